@@ -39,10 +39,9 @@ class AppProvenanceElasticDataReaders :  public NdbDataReaders<AppProvenanceRow,
   public:
     AppProvenanceElasticDataReaders(SConn* connections, int num_readers,const bool hopsworks,
           TimedRestBatcher* restEndpoint) :
-    NdbDataReaders(restEndpoint){
+    NdbDataReaders(restEndpoint, "app_prov"){
       for(int i=0; i<num_readers; i++){
         AppProvenanceElasticDataReader* dr = new AppProvenanceElasticDataReader(connections[i], hopsworks);
-        dr->start(i, this);
         mDataReaders.push_back(dr);
       }
     }
@@ -27,6 +27,8 @@ class AppProvenanceTableTailer : public RCTableTailer<AppProvenanceRow> {
 public:
   AppProvenanceTableTailer(Ndb* ndb, Ndb* ndbRecovery, const int poll_maxTimeToWait, const Barrier barrier);
   AppProvenanceRow consume();
+  std::vector<AppProvenanceRow> consumeBatch(const int max_rows, const ptime deadline);
+  unsigned int getQueueDepth(int queue_id);
   virtual ~AppProvenanceTableTailer();
 
 private:
@@ -21,14 +21,16 @@
 #define BATCHER_H
 
 #include "Utils.h"
-#include <boost/asio.hpp>
-#include <boost/bind.hpp>
+#include "TimerWheel.h"
+#include <atomic>
 #include <boost/date_time/posix_time/posix_time.hpp>
 
 class Batcher {
 public:
   Batcher(const int time_to_wait, const int batch_size);
   void start();
+  void enableIdleFlush(const int min_linger_us);
+  void enableAdaptiveBatchSize(const int max_factor);
   void shutdown();
   void waitToFinish();
   virtual ~Batcher();
@@ -36,25 +38,27 @@ public:
 protected:
   virtual void run() = 0;
   virtual void processBatch() = 0;
+  virtual void timerExpired();
   void resetTimer();
+  bool takeFlushRequest();
+  bool isIdleFlushEnabled() const;
+  int getIdleLingerUS(const Int64 first_pending_us) const;
+  int getAdaptiveBatchSize(const Uint32 backlog_percent) const;
 
   const int mBatchSize;
-  bool mTimerProcessing;
   const int mTimeToWait;
 
 private:
   boost::thread mThread;
   bool mStarted;
-  bool mFirstTimer;
-  bool mScheduleShutdown;
-  bool mShutdownTimer;
-  boost::thread mTimerThread;
-
-  boost::asio::io_service mIOService;
+  std::atomic<bool> mScheduleShutdown;
+  std::atomic<bool> mFlushRequested;
+  Timer mTimer;
+  int mIdleLingerUs;
+  int mMaxBatchFactor;
 
   void startTimer();
-  void timerThread();
-  void timerExpired(const boost::system::error_code& e);
+  void timerFired();
 
 };
 
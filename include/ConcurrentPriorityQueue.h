@@ -22,14 +22,18 @@
 #include "common.h"
 #include <boost/heap/priority_queue.hpp>
 #include <boost/optional.hpp>
+#include <vector>
 
 template<typename Data, typename DataCompartor>
 class ConcurrentPriorityQueue {
 public:
   ConcurrentPriorityQueue();
   void push(Data data);
+  void push_all(std::vector<Data>& data);
   boost::optional<Data> pop();
   void wait_and_pop(Data &result);
+  unsigned int wait_and_pop_all(std::vector<Data>& result,
+      unsigned int max_items, int timeout_us);
   bool empty();
   int size();
   virtual ~ConcurrentPriorityQueue();
@@ -51,6 +55,22 @@ void ConcurrentPriorityQueue<Data, DataCompartor>::push(Data data) {
   mQueueUpdated.notify_one();
 }
 
+/*
+ * the whole batch under one lock and one notification
+ */
+template<typename Data, typename DataCompartor>
+void ConcurrentPriorityQueue<Data, DataCompartor>::push_all(std::vector<Data>& data) {
+  if (data.empty()) {
+    return;
+  }
+  boost::mutex::scoped_lock lock(mLock);
+  for (auto& item : data) {
+    mQueue.push(std::move(item));
+  }
+  lock.unlock();
+  mQueueUpdated.notify_one();
+}
+
 template<typename Data, typename DataCompartor>
 void ConcurrentPriorityQueue<Data, DataCompartor>::wait_and_pop(Data& result) {
   boost::mutex::scoped_lock lock(mLock);
@@ -62,6 +82,27 @@ void ConcurrentPriorityQueue<Data, DataCompartor>::wait_and_pop(Data& result) {
 
 }
 
+/*
+ * waits up to timeout_us for the queue to fill, then takes up to max_items
+ * in priority order. Returns how many were taken
+ */
+template<typename Data, typename DataCompartor>
+unsigned int ConcurrentPriorityQueue<Data, DataCompartor>::wait_and_pop_all(
+    std::vector<Data>& result, unsigned int max_items, int timeout_us) {
+  boost::mutex::scoped_lock lock(mLock);
+  if (!mQueueUpdated.wait_for(lock, boost::chrono::microseconds(timeout_us),
+      [this] { return !mQueue.empty(); })) {
+    return 0;
+  }
+  unsigned int popped = 0;
+  while (popped < max_items && !mQueue.empty()) {
+    result.push_back(mQueue.top());
+    mQueue.pop();
+    popped++;
+  }
+  return popped;
+}
+
 template<typename Data, typename DataCompartor>
 boost::optional<Data> ConcurrentPriorityQueue<Data, DataCompartor>::pop() {
   boost::mutex::scoped_lock lock(mLock);
@@ -28,6 +28,8 @@ public:
   ConcurrentQueue();
   void push(Data data);
   void wait_and_pop(Data &result);
+  bool wait_and_pop(Data &result, int timeout_us);
+  bool try_pop(Data &result);
   bool empty();
   unsigned int size();
   virtual ~ConcurrentQueue();
@@ -60,6 +62,29 @@ void ConcurrentQueue<Data>::wait_and_pop(Data& result) {
 
 }
 
+template<typename Data>
+bool ConcurrentQueue<Data>::wait_and_pop(Data& result, int timeout_us) {
+  boost::mutex::scoped_lock lock(mLock);
+  if (!mQueueUpdated.wait_for(lock, boost::chrono::microseconds(timeout_us),
+      [this] { return !mQueue.empty(); })) {
+    return false;
+  }
+  result = mQueue.front();
+  mQueue.pop();
+  return true;
+}
+
+template<typename Data>
+bool ConcurrentQueue<Data>::try_pop(Data& result) {
+  boost::mutex::scoped_lock lock(mLock);
+  if (mQueue.empty()) {
+    return false;
+  }
+  result = mQueue.front();
+  mQueue.pop();
+  return true;
+}
+
 template<typename Data>
 bool ConcurrentQueue<Data>::empty() {
   boost::mutex::scoped_lock lock(mLock);
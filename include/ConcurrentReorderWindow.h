@@ -0,0 +1,134 @@
+/*
+ * This file is part of ePipe
+ * Copyright (C) 2019, Logical Clocks AB. All rights reserved
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef CONCURRENTREORDERWINDOW_H
+#define CONCURRENTREORDERWINDOW_H
+#include "common.h"
+#include <atomic>
+
+#define DEFAULT_REORDER_WINDOW 1024
+
+/*
+ * Sliding window that restores the order of items published out of order
+ * by several threads. Item i lives in slot i % window; publishing is O(1)
+ * and blocks only while i is a whole window ahead of the next expected
+ * item. The in-order prefix is handed to the drain handler by exactly one
+ * thread at a time. Indexes start at 1.
+ */
+template<typename Data>
+class ConcurrentReorderWindow {
+public:
+  ConcurrentReorderWindow();
+  ConcurrentReorderWindow(Uint32 window);
+  template<typename Handler>
+  void publish(Uint64 index, Data data, Handler handler);
+  Uint64 getNextIndex();
+  virtual ~ConcurrentReorderWindow();
+
+private:
+  enum SlotState {
+    FREE = 0,
+    READY = 1
+  };
+
+  struct Slot {
+    std::atomic<int> mState;
+    Data mData;
+  };
+
+  const Uint64 mWindow;
+  Slot* mSlots;
+  std::atomic<Uint64> mNext;
+  std::atomic<bool> mDraining;
+
+  template<typename Handler>
+  void drain(Handler handler);
+};
+
+template<typename Data>
+ConcurrentReorderWindow<Data>::ConcurrentReorderWindow()
+: ConcurrentReorderWindow(DEFAULT_REORDER_WINDOW) {
+}
+
+template<typename Data>
+ConcurrentReorderWindow<Data>::ConcurrentReorderWindow(Uint32 window)
+: mWindow(window), mNext(1), mDraining(false) {
+  mSlots = new Slot[mWindow];
+  for (Uint64 i = 0; i < mWindow; i++) {
+    mSlots[i].mState.store(FREE, std::memory_order_relaxed);
+  }
+}
+
+template<typename Data>
+template<typename Handler>
+void ConcurrentReorderWindow<Data>::publish(Uint64 index, Data data,
+    Handler handler) {
+  while (index >= mNext.load(std::memory_order_acquire) + mWindow) {
+    boost::this_thread::yield();
+  }
+
+  Slot& slot = mSlots[index % mWindow];
+  slot.mData = std::move(data);
+  slot.mState.store(READY, std::memory_order_seq_cst);
+
+  drain(handler);
+}
+
+template<typename Data>
+template<typename Handler>
+void ConcurrentReorderWindow<Data>::drain(Handler handler) {
+  while (true) {
+    bool expected = false;
+    if (!mDraining.compare_exchange_strong(expected, true,
+        std::memory_order_seq_cst)) {
+      // the thread holding the drain will pick up our item
+      return;
+    }
+
+    Uint64 next = mNext.load(std::memory_order_relaxed);
+    Slot* slot = &mSlots[next % mWindow];
+    while (slot->mState.load(std::memory_order_acquire) == READY) {
+      Data data = std::move(slot->mData);
+      slot->mState.store(FREE, std::memory_order_relaxed);
+      next++;
+      mNext.store(next, std::memory_order_release);
+      handler(data);
+      slot = &mSlots[next % mWindow];
+    }
+
+    mDraining.store(false, std::memory_order_seq_cst);
+
+    // an item published while we were releasing the drain would be lost
+    if (slot->mState.load(std::memory_order_seq_cst) != READY) {
+      return;
+    }
+  }
+}
+
+template<typename Data>
+Uint64 ConcurrentReorderWindow<Data>::getNextIndex() {
+  return mNext.load(std::memory_order_acquire);
+}
+
+template<typename Data>
+ConcurrentReorderWindow<Data>::~ConcurrentReorderWindow() {
+  delete[] mSlots;
+}
+
+#endif /* CONCURRENTREORDERWINDOW_H */
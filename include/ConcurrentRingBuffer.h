@@ -0,0 +1,262 @@
+/*
+ * This file is part of ePipe
+ * Copyright (C) 2019, Logical Clocks AB. All rights reserved
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef CONCURRENTRINGBUFFER_H
+#define CONCURRENTRINGBUFFER_H
+#include "common.h"
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+#define CACHE_LINE_SIZE 64
+#define DEFAULT_RING_CAPACITY 65536
+#define RING_SPINS_BEFORE_SLEEP 1024
+#define RING_FULL_SLEEP_MS 1
+
+/*
+ * Bounded lock-free multi producer, single consumer queue. Every slot carries
+ * a sequence number which tells producers and the consumer whether the slot
+ * is free or holds data for the current lap of the ring. Producers only
+ * touch the condition variable when the consumer went to sleep on an empty
+ * ring, and block (yield, then sleep) when the ring is full, which is how
+ * backpressure reaches the table tailers. push_all and wait_and_pop_all
+ * move a whole chunk of items with a single claim on the ring.
+ */
+template<typename Data>
+class ConcurrentRingBuffer {
+public:
+  ConcurrentRingBuffer();
+  ConcurrentRingBuffer(Uint64 capacity);
+  void push(Data data);
+  void push_all(std::vector<Data>& data);
+  void wait_and_pop(Data &result);
+  unsigned int wait_and_pop_all(std::vector<Data>& result,
+      unsigned int max_items, int timeout_us);
+  bool empty();
+  unsigned int size();
+  virtual ~ConcurrentRingBuffer();
+private:
+  struct Slot {
+    std::atomic<Uint64> mSequence;
+    Data mData;
+  };
+
+  static Uint64 roundUpToPowerOfTwo(Uint64 capacity);
+  void notifyConsumer();
+  void waitForSpace(int& spins);
+
+  const Uint64 mMask;
+  Slot* mSlots;
+
+  char mPad0[CACHE_LINE_SIZE];
+  std::atomic<Uint64> mTail;
+  char mPad1[CACHE_LINE_SIZE];
+  std::atomic<Uint64> mHead;
+  char mPad2[CACHE_LINE_SIZE];
+  std::atomic<bool> mConsumerWaiting;
+  std::mutex mLock;
+  std::condition_variable mQueueUpdated;
+};
+
+template<typename Data>
+ConcurrentRingBuffer<Data>::ConcurrentRingBuffer()
+: ConcurrentRingBuffer(DEFAULT_RING_CAPACITY) {
+}
+
+template<typename Data>
+ConcurrentRingBuffer<Data>::ConcurrentRingBuffer(Uint64 capacity)
+: mMask(roundUpToPowerOfTwo(capacity) - 1), mTail(0), mHead(0),
+mConsumerWaiting(false) {
+  mSlots = new Slot[mMask + 1];
+  for (Uint64 i = 0; i <= mMask; i++) {
+    mSlots[i].mSequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+template<typename Data>
+Uint64 ConcurrentRingBuffer<Data>::roundUpToPowerOfTwo(Uint64 capacity) {
+  Uint64 size = 2;
+  while (size < capacity) {
+    size <<= 1;
+  }
+  return size;
+}
+
+template<typename Data>
+void ConcurrentRingBuffer<Data>::push(Data data) {
+  Uint64 pos = mTail.load(std::memory_order_relaxed);
+  Slot* slot;
+  int spins = 0;
+  while (true) {
+    slot = &mSlots[pos & mMask];
+    Uint64 seq = slot->mSequence.load(std::memory_order_acquire);
+    Int64 diff = static_cast<Int64>(seq) - static_cast<Int64>(pos);
+    if (diff == 0) {
+      if (mTail.compare_exchange_weak(pos, pos + 1,
+          std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      //ring is full, wait for the consumer to free a slot
+      waitForSpace(spins);
+      pos = mTail.load(std::memory_order_relaxed);
+    } else {
+      pos = mTail.load(std::memory_order_relaxed);
+    }
+  }
+
+  slot->mData = std::move(data);
+  slot->mSequence.store(pos + 1, std::memory_order_seq_cst);
+
+  notifyConsumer();
+}
+
+template<typename Data>
+void ConcurrentRingBuffer<Data>::push_all(std::vector<Data>& data) {
+  const Uint64 capacity = mMask + 1;
+  Uint64 pushed = 0;
+  int spins = 0;
+  while (pushed < data.size()) {
+    Uint64 pos = mTail.load(std::memory_order_relaxed);
+    Uint64 head = mHead.load(std::memory_order_acquire);
+    Uint64 freeSlots = capacity - (pos - head);
+    if (freeSlots == 0) {
+      //ring is full, wake up the consumer and wait for it to free slots
+      notifyConsumer();
+      waitForSpace(spins);
+      continue;
+    }
+
+    Uint64 n = std::min<Uint64>(freeSlots, data.size() - pushed);
+    if (!mTail.compare_exchange_weak(pos, pos + n,
+        std::memory_order_relaxed)) {
+      continue;
+    }
+
+    // all the n slots are free since the consumer released them in order
+    for (Uint64 i = 0; i < n; i++) {
+      Slot* slot = &mSlots[(pos + i) & mMask];
+      slot->mData = std::move(data[pushed + i]);
+      slot->mSequence.store(pos + i + 1, std::memory_order_seq_cst);
+    }
+    pushed += n;
+  }
+
+  notifyConsumer();
+}
+
+template<typename Data>
+void ConcurrentRingBuffer<Data>::waitForSpace(int& spins) {
+  if (spins < RING_SPINS_BEFORE_SLEEP) {
+    spins++;
+    boost::this_thread::yield();
+  } else {
+    boost::this_thread::sleep_for(boost::chrono::milliseconds(RING_FULL_SLEEP_MS));
+  }
+}
+
+template<typename Data>
+void ConcurrentRingBuffer<Data>::notifyConsumer() {
+  if (mConsumerWaiting.load(std::memory_order_seq_cst)) {
+    std::lock_guard<std::mutex> lock(mLock);
+    mQueueUpdated.notify_one();
+  }
+}
+
+template<typename Data>
+void ConcurrentRingBuffer<Data>::wait_and_pop(Data& result) {
+  Uint64 pos = mHead.load(std::memory_order_relaxed);
+  Slot* slot = &mSlots[pos & mMask];
+
+  int spins = 0;
+  while (slot->mSequence.load(std::memory_order_acquire) != pos + 1) {
+    if (spins < RING_SPINS_BEFORE_SLEEP) {
+      spins++;
+      boost::this_thread::yield();
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(mLock);
+    mConsumerWaiting.store(true, std::memory_order_seq_cst);
+    mQueueUpdated.wait(lock, [slot, pos] {
+      return slot->mSequence.load(std::memory_order_seq_cst) == pos + 1;
+    });
+    mConsumerWaiting.store(false, std::memory_order_relaxed);
+  }
+
+  result = std::move(slot->mData);
+  slot->mSequence.store(pos + mMask + 1, std::memory_order_release);
+  mHead.store(pos + 1, std::memory_order_release);
+}
+
+template<typename Data>
+unsigned int ConcurrentRingBuffer<Data>::wait_and_pop_all(
+    std::vector<Data>& result, unsigned int max_items, int timeout_us) {
+  Uint64 pos = mHead.load(std::memory_order_relaxed);
+  Slot* slot = &mSlots[pos & mMask];
+
+  int spins = 0;
+  while (slot->mSequence.load(std::memory_order_acquire) != pos + 1) {
+    if (spins < RING_SPINS_BEFORE_SLEEP) {
+      spins++;
+      boost::this_thread::yield();
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(mLock);
+    mConsumerWaiting.store(true, std::memory_order_seq_cst);
+    bool ready = mQueueUpdated.wait_for(lock,
+        std::chrono::microseconds(timeout_us), [slot, pos] {
+      return slot->mSequence.load(std::memory_order_seq_cst) == pos + 1;
+    });
+    mConsumerWaiting.store(false, std::memory_order_relaxed);
+    if (!ready) {
+      return 0;
+    }
+  }
+
+  unsigned int popped = 0;
+  while (popped < max_items
+      && slot->mSequence.load(std::memory_order_acquire) == pos + 1) {
+    result.push_back(std::move(slot->mData));
+    slot->mSequence.store(pos + mMask + 1, std::memory_order_release);
+    pos++;
+    popped++;
+    slot = &mSlots[pos & mMask];
+  }
+  mHead.store(pos, std::memory_order_release);
+  return popped;
+}
+
+template<typename Data>
+bool ConcurrentRingBuffer<Data>::empty() {
+  return size() == 0;
+}
+
+template<typename Data>
+unsigned int ConcurrentRingBuffer<Data>::size() {
+  Uint64 head = mHead.load(std::memory_order_acquire);
+  Uint64 tail = mTail.load(std::memory_order_acquire);
+  return tail > head ? static_cast<unsigned int>(tail - head) : 0;
+}
+
+template<typename Data>
+ConcurrentRingBuffer<Data>::~ConcurrentRingBuffer() {
+  delete[] mSlots;
+}
+
+#endif /* CONCURRENTRINGBUFFER_H */
@@ -23,13 +23,14 @@
 #include "TimedRestBatcher.h"
 #include "http/server/MetricsProvider.h"
 #include "MetricsMovingCounters.h"
+#include "EpochCheckpoint.h"
 
 class ElasticSearchBase : public TimedRestBatcher, public
     MetricsProvider {
 public:
   ElasticSearchBase(const HttpClientConfig elastic_client_config, int
   time_to_wait_before_inserting, int bulk_size, const bool statsEnabled,
-  MovingCountersSet* const metricsCounters);
+  const std::string pipe, MovingCountersSet* const metricsCounters);
   
   virtual ~ElasticSearchBase();
 
@@ -0,0 +1,74 @@
+/*
+ * This file is part of ePipe
+ * Copyright (C) 2019, Logical Clocks AB. All rights reserved
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef EPOCHCHECKPOINT_H
+#define EPOCHCHECKPOINT_H
+
+#include "tables/DBWatchTable.h"
+#include <mutex>
+
+#define EPOCH_CHECKPOINT_INTERVAL_MS 1000
+
+/*
+ * Highest epoch of a log table whose rows were all sent to elastic and
+ * removed, kept in <dir>/<name>.epoch. The tailer tracks every row it hands
+ * on and the sinks acknowledge them through their log handlers once
+ * removeLogs succeeded. A restart only recovers the rows after it. The file
+ * is rewritten at most every EPOCH_CHECKPOINT_INTERVAL_MS, on the next poll
+ * of the tailer once that passed, and right away by flush on shutdown.
+ */
+class EpochCheckpoint {
+public:
+  EpochCheckpoint(const std::string dir, const std::string name);
+  Uint64 getEpoch();
+  void validate(Uint64 clusterEpoch);
+  void track(Uint64 epoch);
+  void handedOut(Uint64 epoch);
+  void hold(Uint64 epoch);
+  void release();
+  void acknowledge(Uint64 epoch);
+  void flush();
+
+  static EpochCheckpoint* create(const std::string dir, LogType type,
+      const std::string name);
+  static EpochCheckpoint* get(LogType type);
+  static void flushAll();
+  static void acknowledgeLog(LogType type, Uint64 epoch);
+  static void acknowledgeLog(const LogHandler* handler);
+  static void acknowledgeLogs(const std::vector<const LogHandler*>& handlers);
+
+private:
+  const std::string mPath;
+  std::mutex mLock;
+  // rows handed on and not yet acknowledged, by epoch
+  std::map<Uint64, Uint32> mPending;
+  // every row up to this epoch was handed on
+  Uint64 mHandedOut;
+  // epoch with lost events, the checkpoint stays below it until released
+  Uint64 mHold;
+  // last persisted
+  Uint64 mEpoch;
+  Int64 mLastPersistUs;
+
+  Uint64 load();
+  void advance(bool force = false);
+  bool persist(Uint64 epoch);
+};
+
+#endif /* EPOCHCHECKPOINT_H */
@@ -0,0 +1,70 @@
+/*
+ * This file is part of ePipe
+ * Copyright (C) 2019, Logical Clocks AB. All rights reserved
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef EVENTHUB_H
+#define EVENTHUB_H
+
+#include "Utils.h"
+
+/*
+ * Receives the events of the operations it subscribed to a hub. All calls
+ * come from the hub thread, in poll order. They hold up the other tables
+ * of the hub, so a subscriber queues the events and handles them on its
+ * own threads.
+ */
+class EventSubscriber {
+public:
+  // after every poll, before the events it returned
+  virtual void eventsPolled(Ndb* ndb) = 0;
+  virtual void eventReceived(NdbEventOperation* op,
+      NdbDictionary::Event::TableEvent event) = 0;
+  // after the last event of the poll
+  virtual void pollDone(Ndb* ndb) = 0;
+  virtual ~EventSubscriber() {
+  }
+};
+
+/*
+ * One Ndb object and thread polling the event operations of many tables.
+ * Events are handed to the subscriber of their operation. An event buffer
+ * gap covers every operation of the Ndb, so it is reported to all of them.
+ * Subscriptions have to be made before the hub is started.
+ */
+class EventHub {
+public:
+  EventHub(Ndb* ndb, const int poll_maxTimeToWait, const std::string name);
+  Ndb* getNdb();
+  void subscribe(NdbEventOperation* op, EventSubscriber* subscriber);
+  void start();
+  void waitToFinish();
+  virtual ~EventHub();
+
+private:
+  Ndb* mNdb;
+  const int mPollMaxTimeToWait;
+  const std::string mName;
+  std::vector<EventSubscriber*> mSubscribers;
+  bool mStarted;
+  boost::thread mThread;
+
+  void run();
+  void pollEvents();
+};
+
+#endif /* EVENTHUB_H */
@@ -62,11 +62,10 @@ class FileProvenanceElasticDataReaders :  public NdbDataReaders<FileProvenanceRo
   public:
     FileProvenanceElasticDataReaders(SConn* hopsConns, int num_readers,const bool hopsworks,
           TimedRestBatcher* restEndpoint, int prov_file_lru_cap, int prov_core_lru_cap, int inodes_lru_ca) :
-    NdbDataReaders(restEndpoint){
+    NdbDataReaders(restEndpoint, "file_prov"){
       for(int i=0; i<num_readers; i++){
         FileProvenanceElasticDataReader* dr
           = new FileProvenanceElasticDataReader(hopsConns[i], hopsworks, prov_file_lru_cap, prov_core_lru_cap, inodes_lru_ca);
-        dr->start(i, this);
         mDataReaders.push_back(dr);
       }
     }
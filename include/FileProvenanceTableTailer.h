@@ -27,16 +27,18 @@ class FileProvenanceTableTailer : public RCTableTailer<FileProvenanceRow> {
 public:
   FileProvenanceTableTailer(Ndb* ndb, Ndb* ndbRecovery, const int poll_maxTimeToWait, const Barrier barrier, int prov_file_lru_cap, int prov_core_lru_ca);
   FileProvenanceRow consume();
+  std::vector<FileProvenanceRow> consumeBatch(const int max_rows, const ptime deadline);
+  unsigned int getQueueDepth(int queue_id);
   virtual ~FileProvenanceTableTailer();
 
 private:
   virtual void handleEvent(NdbDictionary::Event::TableEvent eventType, FileProvenanceRow pre, FileProvenanceRow row);
   void barrierChanged();
 
-  void pushToQueue(PRpq* curr);
+  void pushToQueue(Pq* curr);
 
   CPRq *mQueue;
-  PRpq* mCurrentPriorityQueue;
+  Pq* mCurrentEpochRows;
   boost::mutex mLock;
 
 };
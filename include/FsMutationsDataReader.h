@@ -111,10 +111,9 @@ class FsMutationsDataReaders : public NdbDataReaders<FsMutationRow, MConn>{
 public:
   FsMutationsDataReaders(MConn* connections, int num_readers, const bool hopsworks,
           ProjectsElasticSearch* elastic, const int lru_cap, const std::string search_index,
-          const std::string featurestore_index) : NdbDataReaders(elastic){
+          const std::string featurestore_index, const int lane) : NdbDataReaders(elastic, "fs", lane){
     for(int i=0; i< num_readers; i++){
       FsMutationsDataReader* dr = new FsMutationsDataReader(connections[i], hopsworks, lru_cap, search_index, featurestore_index);
-      dr->start(i, this);
       mDataReaders.push_back(dr);
     }
   }
@@ -26,16 +26,24 @@
 class FsMutationsTableTailer : public RCTableTailer<FsMutationRow> {
 public:
   FsMutationsTableTailer(Ndb* ndb, Ndb* ndbRecovery, const int
-  poll_maxTimeToWait, const Barrier barrier);
+  poll_maxTimeToWait, const Barrier barrier, const int num_lanes);
   FsMutationRow consume();
+  std::vector<FsMutationRow> consumeBatch(const int max_rows, const ptime deadline);
+  FsMutationRow consumeMultiQueue(int queue_id);
+  std::vector<FsMutationRow> consumeMultiQueueBatch(int queue_id,
+      const int max_rows, const ptime deadline);
+  unsigned int getQueueDepth(int queue_id);
+  int getNumLanes() const;
   virtual ~FsMutationsTableTailer();
 
 private:
   virtual void handleEvent(NdbDictionary::Event::TableEvent eventType, FsMutationRow pre, FsMutationRow row);
   void barrierChanged();
-  void pushToQueue(FSpq* curr);
-  CFSq* mQueue;
-  FSpq* mCurrentPriorityQueue;
+  void pushToQueue(FSv* curr);
+  int getLane(const FsMutationRow& row) const;
+  // one queue per dataset lane, rows of a dataset always go to the same lane
+  std::vector<CFSq*> mQueues;
+  FSv* mCurrentEpochRows;
   boost::mutex mLock;
 
   //    double mTimeTakenForEventsToArrive;
@@ -0,0 +1,92 @@
+/*
+ * This file is part of ePipe
+ * Copyright (C) 2019, Logical Clocks AB. All rights reserved
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef MEMORYACCOUNTING_H
+#define MEMORYACCOUNTING_H
+
+#include "Utils.h"
+#include "http/server/MetricsProvider.h"
+#include <atomic>
+
+#define MEMORY_BUDGET_RESUME_PERCENT 90
+
+/*
+ * Bytes held by one stage of a pipe. Stages add what they take over and
+ * release the same amount once they handed it on or dropped it.
+ */
+class MemoryAccount {
+public:
+  MemoryAccount(const std::string pipe, const std::string stage);
+  void add(const Uint64 bytes);
+  void release(const Uint64 bytes);
+  Int64 getBytes() const;
+
+  const std::string mPipe;
+  const std::string mStage;
+
+private:
+  std::atomic<Int64> mBytes;
+};
+
+/*
+ * Process wide registry of the memory accounts. Once the bytes held by all
+ * stages exceed the budget the tailers stop polling until the rest of the
+ * pipeline brought it back below MEMORY_BUDGET_RESUME_PERCENT of the budget.
+ */
+class MemoryAccounting : public MetricsProvider {
+public:
+  static MemoryAccounting& getInstance();
+
+  MemoryAccount* getAccount(const std::string pipe, const std::string stage);
+  void setBudget(const Uint64 bytes);
+  void waitForBudget();
+  Int64 getTotalBytes() const;
+  std::string getMetrics() override;
+
+  template<typename Row>
+  static Uint64 getByteSize(const std::vector<Row>& rows);
+
+private:
+  friend class MemoryAccount;
+
+  MemoryAccounting();
+  void released(const Uint64 bytes);
+
+  boost::mutex mLock;
+  std::vector<MemoryAccount*> mAccounts;
+  std::atomic<Int64> mTotalBytes;
+  std::atomic<Uint64> mBudget;
+  std::atomic<Int64> mResumeBytes;
+  std::atomic<Uint64> mThrottledUs;
+  // tailers waiting for the total to drop to mResumeBytes
+  std::atomic<int> mWaiters;
+  boost::mutex mWaitLock;
+  boost::condition_variable mResumed;
+};
+
+template<typename Row>
+Uint64 MemoryAccounting::getByteSize(const std::vector<Row>& rows) {
+  Uint64 bytes = sizeof(rows);
+  for (auto& row : rows) {
+    bytes += row.getByteSize();
+  }
+  return bytes;
+}
+
+#endif /* MEMORYACCOUNTING_H */
@@ -29,12 +29,17 @@ public:
   MetadataLogTailer(Ndb* ndb, Ndb* ndbRecovery, const int poll_maxTimeToWait,
       const Barrier barrier);
   MetadataLogEntry consume();
+  std::vector<MetadataLogEntry> consumeBatch(const int max_rows, const ptime deadline);
+  unsigned int getQueueDepth(int queue_id);
 
   virtual ~MetadataLogTailer();
 private:
 
   virtual void handleEvent(NdbDictionary::Event::TableEvent eventType, MetadataLogEntry pre, MetadataLogEntry row);
+  void barrierChanged();
   CMetaQ* mSchemaBasedQueue;
+  MetaQ* mCurrentBatch;
+  boost::mutex mLock;
 };
 
 #endif /* METADATALOGTAILER_H */
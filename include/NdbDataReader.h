@@ -23,6 +23,11 @@
 #include "Cache.h"
 #include "Utils.h"
 #include "TimedRestBatcher.h"
+#include "MemoryAccounting.h"
+#include <atomic>
+
+#define READER_STEAL_POLL_MS 10
+#define READER_INITIAL_ROW_COST_US 100
 
 using namespace Utils;
 
@@ -35,21 +40,48 @@ template<typename Data>
 struct IndexedDataBatch{
   std::vector<Data>* mDataBatch;
   Uint64 mIndex;
+  Uint64 mBytes;
   IndexedDataBatch(){
     
   }
-  IndexedDataBatch(Uint64 index, std::vector<Data>* data){
+  IndexedDataBatch(Uint64 index, std::vector<Data>* data, Uint64 bytes){
    mIndex = index;
    mDataBatch = data;
+   mBytes = bytes;
+  }
+};
+
+/*
+ * Load and utilization counters of a reader, readers only update their own
+ * counters, the dispatcher and the metrics endpoint read them.
+ */
+struct DataReaderStats {
+  std::atomic<Uint64> mQueuedBatches;
+  std::atomic<Uint64> mQueuedRows;
+  std::atomic<Uint64> mInFlightRows;
+  std::atomic<Int64> mInFlightSinceUs;
+  std::atomic<Uint64> mRowCostUs;
+  std::atomic<Uint64> mBusyUs;
+  std::atomic<Uint64> mProcessedBatches;
+  std::atomic<Uint64> mProcessedRows;
+  std::atomic<Uint64> mStolenBatches;
+
+  DataReaderStats() : mQueuedBatches(0), mQueuedRows(0), mInFlightRows(0),
+  mInFlightSinceUs(0), mRowCostUs(READER_INITIAL_ROW_COST_US), mBusyUs(0),
+  mProcessedBatches(0), mProcessedRows(0), mStolenBatches(0) {
   }
 };
 
 template<typename Data, typename Conn>
 class NdbDataReader {
 public:
+  typedef std::vector<NdbDataReader<Data, Conn>* > Peers;
   NdbDataReader(Conn connection, const bool hopsworks);
-  void start(int readerId, DataReaderOutHandler* outHandler);
-  void processBatch(Uint64 index, std::vector<Data>* data_batch);
+  void start(int readerId, DataReaderOutHandler* outHandler, Peers* peers,
+      MemoryAccount* batchBytes);
+  void processBatch(IndexedDataBatch<Data> batch);
+  Uint64 getEstimatedLoadUs();
+  const DataReaderStats& getStats() const;
   virtual ~NdbDataReader();
   
 protected:
@@ -62,21 +94,32 @@ protected:
  private:
   int mReaderId;
   DataReaderOutHandler* mOutHandler;
+  Peers* mPeers;
+  MemoryAccount* mBatchBytes;
   ConcurrentQueue<IndexedDataBatch<Data> >* mBatchedQueue;
+  DataReaderStats mStats;
   void run();
+  bool nextBatch(IndexedDataBatch<Data>& batch);
+  bool steal(IndexedDataBatch<Data>& batch);
+  bool popQueued(IndexedDataBatch<Data>& batch);
+  void process(IndexedDataBatch<Data>& batch);
+  void release(IndexedDataBatch<Data>& batch);
 };
 
 template<typename Data, typename Conn>
 NdbDataReader<Data, Conn>::NdbDataReader(Conn connection, const bool hopsworks)
-: mNdbConnection(connection), mHopsworksEnabled(hopsworks) {
+: mNdbConnection(connection), mHopsworksEnabled(hopsworks), mPeers(nullptr) {
   mBatchedQueue = new ConcurrentQueue<IndexedDataBatch<Data> >();
 }
 
 template<typename Data, typename Conn>
-void NdbDataReader<Data, Conn>::start(int readerId, DataReaderOutHandler* outHandler) {
+void NdbDataReader<Data, Conn>::start(int readerId, DataReaderOutHandler* outHandler,
+    Peers* peers, MemoryAccount* batchBytes) {
   mOutHandler = outHandler;
-  mThread = boost::thread(&NdbDataReader::run, this);
+  mPeers = peers;
+  mBatchBytes = batchBytes;
   mReaderId = readerId;
+  mThread = boost::thread(&NdbDataReader::run, this);
   LOG_DEBUG("Reader-" << readerId << " created with thread "  << mThread.get_id());
 }
 
@@ -84,36 +127,149 @@ template<typename Data, typename Conn>
 void NdbDataReader<Data, Conn>::run() {
   while (true) {
     IndexedDataBatch<Data> batch;
-    mBatchedQueue->wait_and_pop(batch);
+    if (nextBatch(batch)) {
+      process(batch);
+    }
+  }
+}
 
-    if (!batch.mDataBatch->empty()) {
-      eBulk bulk;
+template<typename Data, typename Conn>
+bool NdbDataReader<Data, Conn>::nextBatch(IndexedDataBatch<Data>& batch) {
+  if (mPeers == nullptr) {
+    mBatchedQueue->wait_and_pop(batch);
+  } else if (popQueued(batch) || steal(batch)) {
+    return true;
+  } else if (!mBatchedQueue->wait_and_pop(batch, READER_STEAL_POLL_MS * 1000)) {
+    return false;
+  }
+  mStats.mQueuedBatches--;
+  mStats.mQueuedRows -= batch.mDataBatch->size();
+  return true;
+}
 
-      bulk.mProcessingIndex = batch.mIndex;
-      
-      bulk.mStartProcessing = getCurrentTime();
+/*
+ * take the oldest batch of the peer with the most queued rows. Taking the
+ * oldest one keeps the lowest outstanding index runnable, which the reorder
+ * window relies on.
+ */
+template<typename Data, typename Conn>
+bool NdbDataReader<Data, Conn>::steal(IndexedDataBatch<Data>& batch) {
+  NdbDataReader<Data, Conn>* victim = nullptr;
+  Uint64 maxQueuedRows = 0;
+  for (auto peer : *mPeers) {
+    if (peer == this || peer->mStats.mQueuedBatches == 0) {
+      continue;
+    }
+    Uint64 queuedRows = peer->mStats.mQueuedRows;
+    if (victim == nullptr || queuedRows > maxQueuedRows) {
+      victim = peer;
+      maxQueuedRows = queuedRows;
+    }
+  }
 
-      processAddedandDeleted(batch.mDataBatch, bulk);
-      
-      bulk.mEndProcessing = getCurrentTime();
+  if (victim == nullptr || !victim->popQueued(batch)) {
+    return false;
+  }
 
-      bulk.sortArrivalTimes();
+  mStats.mStolenBatches++;
+  LOG_DEBUG("Reader-" << mReaderId << " stole batch " << batch.mIndex
+      << " from Reader-" << victim->mReaderId);
+  return true;
+}
 
-      mOutHandler->writeOutput(bulk);
-      
-      LOG_DEBUG("Reader-" << mReaderId << " processing batch " << batch.mIndex << " of size [" << batch.mDataBatch->size() << "] took "
-          << getTimeDiffInMilliseconds(bulk.mStartProcessing, bulk.mEndProcessing) << " msec");
-    }
+template<typename Data, typename Conn>
+bool NdbDataReader<Data, Conn>::popQueued(IndexedDataBatch<Data>& batch) {
+  if (!mBatchedQueue->try_pop(batch)) {
+    return false;
+  }
+  mStats.mQueuedBatches--;
+  mStats.mQueuedRows -= batch.mDataBatch->size();
+  return true;
+}
 
+template<typename Data, typename Conn>
+void NdbDataReader<Data, Conn>::process(IndexedDataBatch<Data>& batch) {
+  if (batch.mDataBatch->empty()) {
+    release(batch);
+    return;
   }
+
+  Uint64 rows = batch.mDataBatch->size();
+  Int64 startUs = getMonotonicTimeInMicroseconds();
+  mStats.mInFlightRows = rows;
+  mStats.mInFlightSinceUs = startUs;
+
+  eBulk bulk;
+
+  bulk.mProcessingIndex = batch.mIndex;
+
+  bulk.mStartProcessing = getCurrentTime();
+
+  processAddedandDeleted(batch.mDataBatch, bulk);
+
+  release(batch);
+
+  bulk.mEndProcessing = getCurrentTime();
+
+  bulk.sortArrivalTimes();
+
+  Uint64 tookUs = getMonotonicTimeInMicroseconds() - startUs;
+  mStats.mInFlightSinceUs = 0;
+  mStats.mInFlightRows = 0;
+  mStats.mBusyUs += tookUs;
+  mStats.mProcessedBatches++;
+  mStats.mProcessedRows += rows;
+  Uint64 rowCost = std::max<Uint64>(tookUs / rows, 1);
+  mStats.mRowCostUs = (7 * mStats.mRowCostUs + rowCost) / 8;
+
+  mOutHandler->writeOutput(bulk);
+
+  LOG_DEBUG("Reader-" << mReaderId << " processing batch " << batch.mIndex << " of size [" << rows << "] took "
+      << getTimeDiffInMilliseconds(bulk.mStartProcessing, bulk.mEndProcessing) << " msec");
+}
+
+/*
+ * the rows are not needed once the bulk is built, the batch is owned by the
+ * reader from the moment it was handed in
+ */
+template<typename Data, typename Conn>
+void NdbDataReader<Data, Conn>::release(IndexedDataBatch<Data>& batch) {
+  mBatchBytes->release(batch.mBytes);
+  delete batch.mDataBatch;
+  batch.mDataBatch = nullptr;
 }
 
 template<typename Data, typename Conn>
-void NdbDataReader<Data, Conn>::processBatch(Uint64 index, std::vector<Data>* data_batch) {
-  mBatchedQueue->push(IndexedDataBatch<Data>(index, data_batch));
+void NdbDataReader<Data, Conn>::processBatch(IndexedDataBatch<Data> batch) {
+  mStats.mQueuedRows += batch.mDataBatch->size();
+  mStats.mQueuedBatches++;
+  Uint64 index = batch.mIndex;
+  mBatchedQueue->push(batch);
   LOG_DEBUG("Reader-" << mReaderId << ": Process batch " << index);
 }
 
+/*
+ * estimated time until the reader drains its queue. A batch in flight counts
+ * at least for the time it has been running so a stalled reader keeps
+ * getting more expensive.
+ */
+template<typename Data, typename Conn>
+Uint64 NdbDataReader<Data, Conn>::getEstimatedLoadUs() {
+  Uint64 rowCost = mStats.mRowCostUs;
+  Uint64 load = mStats.mQueuedRows * rowCost;
+  Int64 inFlightSince = mStats.mInFlightSinceUs;
+  if (inFlightSince > 0) {
+    Uint64 elapsed = getMonotonicTimeInMicroseconds() - inFlightSince;
+    load += std::max<Uint64>(mStats.mInFlightRows * rowCost, elapsed);
+  }
+  return load;
+}
+
+template<typename Data, typename Conn>
+const DataReaderStats& NdbDataReader<Data, Conn>::getStats() const {
+  return mStats;
+}
+
 template<typename Data, typename Conn>
 NdbDataReader<Data, Conn>::~NdbDataReader() {
 
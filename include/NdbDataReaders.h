@@ -21,64 +21,86 @@
 #define NDBDATAREADERS_H
 
 #include "NdbDataReader.h"
-#include "ConcurrentPriorityQueue.h"
+#include "ConcurrentReorderWindow.h"
+#include "WatermarkGate.h"
+#include "http/server/MetricsProvider.h"
 #include <boost/atomic.hpp>
 
 typedef boost::atomic<Uint64> AtomicLong;
 
-struct BulkIndexComparator {
-  
-  bool operator()(const eBulk &r1, const eBulk &r2) const {
-    return r1.mProcessingIndex > r2.mProcessingIndex;
-  }
-};
-
 template<typename Data, typename Conn>
-class NdbDataReaders : public DataReaderOutHandler{
+class NdbDataReaders : public DataReaderOutHandler, public MetricsProvider{
 public:
   typedef std::vector<NdbDataReader<Data, Conn>* > DataReadersVec;
   typedef typename DataReadersVec::size_type drvec_size_type;
-  NdbDataReaders(TimedRestBatcher* elastic);
-  void start();
+  NdbDataReaders(TimedRestBatcher* elastic, const std::string pipe);
+  NdbDataReaders(TimedRestBatcher* elastic, const std::string pipe,
+      const int lane);
+  void start(const bool work_stealing);
+  void setWatermarks(const Watermarks watermarks);
   void processBatch(std::vector<Data>* data_batch);
   void writeOutput(eBulk out);
+  const std::string& getPipe() const;
+  std::string getMetrics() override;
   virtual ~NdbDataReaders();
   
 private:
   TimedRestBatcher* timedRestBatcher;
+  const std::string mPipe;
+  const int mLane;
   bool mStarted;
+  Int64 mStartTimeUs;
   boost::thread mThread;
   
-  ConcurrentQueue<std::vector<Data>*>* mBatchedQueue;
-  ConcurrentPriorityQueue<eBulk, BulkIndexComparator >* mWaitingOutQueue;
+  ConcurrentQueue<IndexedDataBatch<Data> >* mBatchedQueue;
+  ConcurrentReorderWindow<eBulk>* mWaitingOutWindow;
+  // batches handed in and not yet passed on to the rest batcher
+  WatermarkGate mOutstanding;
+  // rows of the batches handed in and not yet read
+  MemoryAccount* mBatchBytes;
+  // bulks waiting in the reorder window
+  MemoryAccount* mReorderBytes;
   
-  AtomicLong mLastSent;
   AtomicLong mCurrIndex;
-  drvec_size_type mRoundRobinDrIndex;
+  drvec_size_type mLastDrIndex;
   
   void run();
-  void processWaiting();
+  drvec_size_type leastLoadedReader();
   
 protected:
   std::vector<NdbDataReader<Data, Conn>* > mDataReaders;
 };
 
 template<typename Data, typename Conn>
-NdbDataReaders<Data, Conn>::NdbDataReaders(TimedRestBatcher* batcher) : timedRestBatcher(batcher) {
+NdbDataReaders<Data, Conn>::NdbDataReaders(TimedRestBatcher* batcher,
+    const std::string pipe) : NdbDataReaders(batcher, pipe, -1) {
+}
+
+template<typename Data, typename Conn>
+NdbDataReaders<Data, Conn>::NdbDataReaders(TimedRestBatcher* batcher,
+    const std::string pipe, const int lane) : timedRestBatcher(batcher),
+    mPipe(pipe), mLane(lane) {
   mStarted = false;
-  mBatchedQueue = new ConcurrentQueue<std::vector<Data>*>();
-  mWaitingOutQueue = new ConcurrentPriorityQueue<eBulk, BulkIndexComparator>();
-  mLastSent = 0; 
+  mStartTimeUs = 0;
+  mBatchedQueue = new ConcurrentQueue<IndexedDataBatch<Data> >();
+  mWaitingOutWindow = new ConcurrentReorderWindow<eBulk>();
+  mBatchBytes = MemoryAccounting::getInstance().getAccount(pipe, "reader_batches");
+  mReorderBytes = MemoryAccounting::getInstance().getAccount(pipe, "reorder");
   mCurrIndex = 0;
-  mRoundRobinDrIndex = -1;
+  mLastDrIndex = -1;
 }
 
 template<typename Data, typename Conn>
-void NdbDataReaders<Data, Conn>::start() {
+void NdbDataReaders<Data, Conn>::start(const bool work_stealing) {
   if (mStarted) {
     return;
   }
   
+  for (drvec_size_type i = 0; i < mDataReaders.size(); i++) {
+    mDataReaders[i]->start(i, this, work_stealing ? &mDataReaders : nullptr,
+        mBatchBytes);
+  }
+  mStartTimeUs = getMonotonicTimeInMicroseconds();
   mThread = boost::thread(&NdbDataReaders::run, this);
   mStarted = true;
 }
@@ -87,55 +109,107 @@ void NdbDataReaders<Data, Conn>::start() {
 template<typename Data, typename Conn>
 void NdbDataReaders<Data, Conn>::run() {
   while (true) {
-    std::vector<Data>* curr;
+    IndexedDataBatch<Data> curr;
     mBatchedQueue->wait_and_pop(curr);
     
-    if(mRoundRobinDrIndex < mDataReaders.size()){
-      mRoundRobinDrIndex++;
-    }
+    mLastDrIndex = leastLoadedReader();
     
-    if(mRoundRobinDrIndex >= mDataReaders.size()){
-      mRoundRobinDrIndex = 0;
+    curr.mIndex = ++mCurrIndex;
+    mDataReaders[mLastDrIndex]->processBatch(curr);
+  }
+}
+
+/*
+ * pick the reader with the smallest estimated backlog, ties are broken
+ * round robin so idle readers share the work evenly
+ */
+template<typename Data, typename Conn>
+typename NdbDataReaders<Data, Conn>::drvec_size_type NdbDataReaders<Data, Conn>::leastLoadedReader() {
+  drvec_size_type n = mDataReaders.size();
+  drvec_size_type best = (mLastDrIndex + 1) % n;
+  Uint64 bestLoad = mDataReaders[best]->getEstimatedLoadUs();
+  for (drvec_size_type i = 1; i < n && bestLoad > 0; i++) {
+    drvec_size_type candidate = (best + i) % n;
+    Uint64 load = mDataReaders[candidate]->getEstimatedLoadUs();
+    if (load < bestLoad) {
+      best = candidate;
+      bestLoad = load;
     }
-    
-    mDataReaders[mRoundRobinDrIndex]->processBatch(++mCurrIndex, curr);
   }
+  return best;
+}
+
+template<typename Data, typename Conn>
+void NdbDataReaders<Data, Conn>::setWatermarks(const Watermarks watermarks) {
+  mOutstanding.setWatermarks(watermarks);
 }
 
+/*
+ * blocks while the readers are above their high watermark
+ */
 template<typename Data, typename Conn>
 void NdbDataReaders<Data, Conn>::processBatch(std::vector<Data>* data_batch) {
-  mBatchedQueue->push(data_batch);
+  mOutstanding.acquire(1);
+  Uint64 bytes = MemoryAccounting::getByteSize(*data_batch);
+  mBatchBytes->add(bytes);
+  mBatchedQueue->push(IndexedDataBatch<Data>(0, data_batch, bytes));
 }
 
 template<typename Data, typename Conn>
 void NdbDataReaders<Data, Conn>::writeOutput(eBulk out) {
-  mWaitingOutQueue->push(out);
-  processWaiting();
+  TimedRestBatcher* batcher = timedRestBatcher;
+  WatermarkGate* outstanding = &mOutstanding;
+  MemoryAccount* reorderBytes = mReorderBytes;
+  Uint64 index = out.mProcessingIndex;
+  reorderBytes->add(out.getByteSize());
+  mWaitingOutWindow->publish(index, std::move(out), [batcher, outstanding, reorderBytes](eBulk& bulk) {
+    LOG_INFO("publish enriched events with index [" << bulk.mProcessingIndex << "] to Elastic");
+    batcher->addData(bulk);
+    reorderBytes->release(bulk.getByteSize());
+    outstanding->release(1);
+  });
+}
+
+template<typename Data, typename Conn>
+const std::string& NdbDataReaders<Data, Conn>::getPipe() const {
+  return mPipe;
 }
 
 template<typename Data, typename Conn>
-void NdbDataReaders<Data, Conn>::processWaiting() {
-  while (!mWaitingOutQueue->empty()) {
-    boost::optional<eBulk> out_ptr = mWaitingOutQueue->pop();
-    if (out_ptr) {
-      eBulk out = out_ptr.get();
-      if (out.mProcessingIndex == mLastSent + 1) {
-        LOG_INFO("publish enriched events with index [" << out.mProcessingIndex << "] to Elastic");
-        timedRestBatcher->addData(out);
-        mLastSent++;
-      } else {
-        mWaitingOutQueue->push(out);
-        break;
-      }
-    } else {
-      break;
+std::string NdbDataReaders<Data, Conn>::getMetrics() {
+  std::stringstream out;
+  Int64 upUs = std::max<Int64>(getMonotonicTimeInMicroseconds() - mStartTimeUs, 1);
+  std::string laneLabel = mLane >= 0 ? "{lane=\"" + std::to_string(mLane) + "\"} " : " ";
+  out << "epipe_" << mPipe << "_readers_outstanding_batches" << laneLabel
+      << mOutstanding.getCount() << std::endl;
+  out << "epipe_" << mPipe << "_readers_backpressure_seconds" << laneLabel
+      << mOutstanding.getBlockedTimeUs() / 1000000.0 << std::endl;
+  for (drvec_size_type i = 0; i < mDataReaders.size(); i++) {
+    const DataReaderStats& stats = mDataReaders[i]->getStats();
+    std::string label = "{reader=\"" + std::to_string(i) + "\"} ";
+    if (mLane >= 0) {
+      label = "{lane=\"" + std::to_string(mLane) + "\",reader=\""
+          + std::to_string(i) + "\"} ";
     }
+    std::string prefix = "epipe_" + mPipe + "_reader_";
+    out << prefix << "utilization" << label
+        << static_cast<double>(stats.mBusyUs) / upUs << std::endl;
+    out << prefix << "queued_batches" << label << stats.mQueuedBatches << std::endl;
+    out << prefix << "queued_rows" << label << stats.mQueuedRows << std::endl;
+    out << prefix << "estimated_load_microseconds" << label
+        << mDataReaders[i]->getEstimatedLoadUs() << std::endl;
+    out << prefix << "avg_row_cost_microseconds" << label << stats.mRowCostUs << std::endl;
+    out << prefix << "processed_batches" << label << stats.mProcessedBatches << std::endl;
+    out << prefix << "processed_rows" << label << stats.mProcessedRows << std::endl;
+    out << prefix << "stolen_batches" << label << stats.mStolenBatches << std::endl;
   }
+  return out.str();
 }
 
 template<typename Data, typename Conn>
 NdbDataReaders<Data, Conn>::~NdbDataReaders() {
   delete mBatchedQueue;
+  delete mWaitingOutWindow;
 }
 
 #endif /* NDBDATAREADERS_H */
@@ -49,7 +49,14 @@ public:
           const int elastic_batch_size, const int elastic_issue_time,
           const int lru_cap, const int prov_file_lru_cap, const int prov_core_lru_cap, const bool recovery, const bool stats,
           Barrier barrier, const bool hiveCleaner, const std::string
-          metricsServer);
+          metricsServer, const bool work_stealing, const int fs_mutations_lanes,
+          const int idle_flush_linger_us, const Watermarks reader_watermarks,
+          const Watermarks elastic_watermarks, const int eventbuf_max_alloc_mb,
+          const int memory_budget_mb, const int tailer_decode_workers,
+          const int eventbuf_free_percent, const int adaptive_batch_factor,
+          const bool gap_recovery, const int event_hubs,
+          const int recovery_batch_rows, const int recovery_scan_parallelism,
+          const int recovery_scan_batch, const std::string checkpoint_dir);
   void start();
   virtual ~Notifier();
 
@@ -76,12 +83,29 @@ private:
   const Barrier mBarrier;
   const bool mHiveCleaner;
   const std::string mMetricsServer;
+  const bool mWorkStealing;
+  const int mFsMutationsLanes;
+  const int mIdleFlushLingerUs;
+  const Watermarks mReaderWatermarks;
+  const Watermarks mElasticWatermarks;
+  const int mEventBufMaxAllocMB;
+  const int mMemoryBudgetMB;
+  const int mTailerDecodeWorkers;
+  const int mEventBufFreePercent;
+  const int mAdaptiveBatchFactor;
+  const bool mGapRecovery;
+  const int mEventHubs;
+  const int mRecoveryBatchRows;
+  const int mRecoveryScanParallelism;
+  const int mRecoveryScanBatch;
+  const std::string mCheckpointDir;
 
   ProjectsElasticSearch* mProjectsElasticSearch;
 
   FsMutationsTableTailer* mFsMutationsTableTailer;
-  FsMutationsDataReaders* mFsMutationsDataReaders;
-  FsMutationsBatcher* mFsMutationsBatcher;
+  // one reader set and batcher per dataset lane
+  std::vector<FsMutationsDataReaders*> mFsMutationsDataReaders;
+  std::vector<FsMutationsBatcher*> mFsMutationsBatchers;
 
   MetadataLogTailer* mMetadataLogTailer;
 
@@ -107,9 +131,18 @@ private:
   SkewedLocTailer* mSkewedLocTailer;
   SkewedValuesTailer* mSkewedValuesTailer;
 
+  // event hubs per database, empty unless event_hubs is set
+  boost::unordered_map<std::string, std::vector<EventHub*>> mEventHubsByDatabase;
+  boost::unordered_map<std::string, int> mNextEventHub;
+
   HttpServer* mHttpServer;
   MetricsProviders* mMetricsProviders;
   void setup();
+  Ndb* create_tailer_ndb_connection(const char* database);
+  Ndb* create_event_ndb_connection(const char* database);
+  EventHub* get_event_hub(const char* database);
+  std::vector<Ndb*> create_recovery_scan_connections(const char* database);
+  EpochCheckpoint* create_checkpoint(LogType type, const std::string name);
 };
 
 #endif /* NOTIFIER_H */
@@ -39,6 +39,10 @@ private:
   const int mQueueId;
 
   int mCurrentCount;
+  Uint64 mCurrentBytes;
+  // rows consumed from the tailer and not yet handed to the readers
+  MemoryAccount* mPendingBytes;
+  Int64 mFirstPendingUs;
   boost::mutex mLock;
   std::vector<DataRow>* mOperations;
   virtual void run();
@@ -50,6 +54,10 @@ RCBatcher<DataRow, Conn>::RCBatcher(RCTableTailer<DataRow>* table_tailer, NdbDat
         const int time_before_issuing_ndb_reqs, const int batch_size)
 : Batcher(time_before_issuing_ndb_reqs, batch_size), mTableTailer(table_tailer), mNdbDataReaders(ndb_data_readers), mQueueId(SINGLE_QUEUE) {
   mCurrentCount = 0;
+  mCurrentBytes = 0;
+  mPendingBytes = MemoryAccounting::getInstance().getAccount(
+      ndb_data_readers->getPipe(), "batcher");
+  mFirstPendingUs = 0;
   mOperations = new std::vector<DataRow>();
 }
 
@@ -58,39 +66,93 @@ RCBatcher<DataRow, Conn>::RCBatcher(RCTableTailer<DataRow>* table_tailer, NdbDat
         const int time_before_issuing_ndb_reqs, const int batch_size, const int queue_id)
 : Batcher(time_before_issuing_ndb_reqs, batch_size), mTableTailer(table_tailer), mNdbDataReaders(ndb_data_readers), mQueueId(queue_id) {
   mCurrentCount = 0;
+  mCurrentBytes = 0;
+  mPendingBytes = MemoryAccounting::getInstance().getAccount(
+      ndb_data_readers->getPipe(), "batcher");
+  mFirstPendingUs = 0;
   mOperations = new std::vector<DataRow>();
 }
 
 template<typename DataRow, typename Conn>
 void RCBatcher<DataRow, Conn>::run() {
   while (true) {
-    DataRow row = mTableTailer->consumeMultiQueue(mQueueId);
+    int batchSize = getAdaptiveBatchSize(
+        mTableTailer->getEventBufferUsagePercent());
+    mLock.lock();
+    int remaining = std::max(1, batchSize - mCurrentCount);
+    Int64 firstPendingUs = mCurrentCount > 0 ? mFirstPendingUs : 0;
+    mLock.unlock();
+
+    Int64 timeoutUs = static_cast<Int64>(mTimeToWait) * 1000;
+    if (firstPendingUs > 0) {
+      // wake up once the pending rows waited a full interval
+      Int64 ageUs = Utils::getMonotonicTimeInMicroseconds() - firstPendingUs;
+      timeoutUs = std::max<Int64>(0, timeoutUs - ageUs);
+      if (isIdleFlushEnabled()) {
+        timeoutUs = std::min<Int64>(timeoutUs, getIdleLingerUS(firstPendingUs));
+      }
+    }
+    ptime deadline = Utils::getCurrentTime() +
+        boost::posix_time::microseconds(timeoutUs);
+
+    std::vector<DataRow> rows;
+    if (mQueueId == SINGLE_QUEUE) {
+      rows = mTableTailer->consumeBatch(remaining, deadline);
+    } else {
+      rows = mTableTailer->consumeMultiQueueBatch(mQueueId, remaining,
+          deadline);
+    }
+    bool idle = mTableTailer->getQueueDepth(mQueueId) == 0;
+    Uint64 bytes = 0;
+    for (auto& row : rows) {
+      bytes += row.getByteSize();
+    }
+    mPendingBytes->add(bytes);
 
     mLock.lock();
-    mOperations->push_back(row);
-    mCurrentCount++;
+    if (!rows.empty()) {
+      if (mCurrentCount == 0) {
+        mFirstPendingUs = Utils::getMonotonicTimeInMicroseconds();
+      }
+      mOperations->insert(mOperations->end(),
+          std::make_move_iterator(rows.begin()),
+          std::make_move_iterator(rows.end()));
+      mCurrentCount += rows.size();
+      mCurrentBytes += bytes;
+    }
+    bool batchFull = mCurrentCount >= batchSize;
+    bool idleFlush = idle && isIdleFlushEnabled() && mCurrentCount > 0
+        && getIdleLingerUS(mFirstPendingUs) == 0;
+    bool expired = mCurrentCount > 0 && Utils::getMonotonicTimeInMicroseconds()
+        - mFirstPendingUs >= static_cast<Int64>(mTimeToWait) * 1000;
     mLock.unlock();
 
-    if (mCurrentCount == mBatchSize && !mTimerProcessing) {
+    bool timerFlush = takeFlushRequest();
+    if (batchFull || idleFlush) {
       resetTimer();
       processBatch();
+    } else if (timerFlush || expired) {
+      processBatch();
     }
   }
 }
 
 template<typename DataRow, typename Conn>
 void RCBatcher<DataRow, Conn>::processBatch() {
-  if (mCurrentCount > 0) {
-    LOG_DEBUG("process batch");
-
-    mLock.lock();
-    std::vector<DataRow>* added_deleted_batch = mOperations;
-    mOperations = new std::vector<DataRow>();
-    mCurrentCount = 0;
+  mLock.lock();
+  if (mCurrentCount == 0) {
     mLock.unlock();
-
-    mNdbDataReaders->processBatch(added_deleted_batch);
+    return;
   }
+  LOG_DEBUG("process batch");
+  std::vector<DataRow>* added_deleted_batch = mOperations;
+  mOperations = new std::vector<DataRow>();
+  mCurrentCount = 0;
+  Uint64 bytes = mCurrentBytes;
+  mCurrentBytes = 0;
+  mLock.unlock();
+
+  mNdbDataReaders->processBatch(added_deleted_batch);
+  mPendingBytes->release(bytes);
 }
 #endif /* RCBATCHER_H */
-
@@ -29,9 +29,11 @@ class RCTableTailer : public TableTailer<TableRow> {
 public:
 
   RCTableTailer(Ndb* ndb, Ndb* ndbRecovery, DBWatchTable<TableRow>* table,
-      const int poll_maxTimeToWait, const Barrier barrier)
+      const int poll_maxTimeToWait, const Barrier barrier,
+      const std::string pipe)
   : TableTailer<TableRow>(ndb, ndbRecovery, table, poll_maxTimeToWait,
       barrier) {
+    mQueuedBytes = MemoryAccounting::getInstance().getAccount(pipe, "tailer");
   }
 
   virtual TableRow consumeMultiQueue(int queue_id) {
@@ -39,7 +41,62 @@ public:
     return consume();
   }
 
+  virtual std::vector<TableRow> consumeMultiQueueBatch(int queue_id,
+      const int max_rows, const ptime deadline) {
+    std::vector<TableRow> rows;
+    rows.push_back(consumeMultiQueue(queue_id));
+    return rows;
+  }
+
+  /*
+   * hand over up to max_rows rows in one operation, waiting at most until
+   * the deadline for rows to arrive. The default behaviour is to block for a
+   * single row.
+   */
+  virtual std::vector<TableRow> consumeBatch(const int max_rows,
+      const ptime deadline) {
+    std::vector<TableRow> rows;
+    rows.push_back(consume());
+    return rows;
+  }
+
   virtual TableRow consume() = 0;
+
+  /*
+   * rows of completed epochs waiting in the queue the batcher consumes from,
+   * SINGLE_QUEUE stands for the queue consumeBatch reads
+   */
+  virtual unsigned int getQueueDepth(int queue_id) = 0;
+
+protected:
+  // rows of completed epochs not yet consumed by the batcher. Rows of the
+  // current epoch are left out, they only move on once the tailer polls.
+  MemoryAccount* mQueuedBytes;
+
+  void accountQueued(const TableRow& row) {
+    mQueuedBytes->add(row.getByteSize());
+  }
+
+  void accountQueued(const std::vector<TableRow>& rows) {
+    for (auto& row : rows) {
+      accountQueued(row);
+    }
+  }
+
+  void accountConsumed(const TableRow& row) {
+    mQueuedBytes->release(row.getByteSize());
+  }
+
+  void accountConsumed(const std::vector<TableRow>& rows) {
+    for (auto& row : rows) {
+      accountConsumed(row);
+    }
+  }
+
+  int getTimeoutUS(const ptime deadline) {
+    Int64 timeout = (deadline - Utils::getCurrentTime()).total_microseconds();
+    return timeout > 0 ? static_cast<int>(timeout) : 0;
+  }
 };
 
 #endif /* RCTABLETAILER_H */
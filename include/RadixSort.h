@@ -0,0 +1,116 @@
+/*
+ * This file is part of ePipe
+ * Copyright (C) 2019, Logical Clocks AB. All rights reserved
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef RADIXSORT_H
+#define RADIXSORT_H
+#include "common.h"
+
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+
+struct RadixKey {
+  Uint64 mHigh;
+  Uint32 mLow;
+  Uint32 mIndex;
+};
+
+/*
+ * map signed integers to unsigned ones with the same ordering
+ */
+inline static Uint64 radix_key(Int64 value) {
+  return static_cast<Uint64>(value) ^ (static_cast<Uint64>(1) << 63);
+}
+
+inline static Uint32 radix_key(Int32 value) {
+  return static_cast<Uint32>(value) ^ (static_cast<Uint32>(1) << 31);
+}
+
+/*
+ * LSD radix sort of the keys on (mHigh, mLow), 8 bits per pass. Passes where
+ * all keys share the same digit are skipped, which is the common case for
+ * the upper bytes of inode ids and logical times.
+ */
+inline static void radix_sort_keys(std::vector<RadixKey>& keys) {
+  std::vector<RadixKey> buffer(keys.size());
+  const int passes = (64 + 32) / RADIX_BITS;
+  for (int pass = 0; pass < passes; pass++) {
+    const bool low = pass < 32 / RADIX_BITS;
+    const int shift = (low ? pass : pass - 32 / RADIX_BITS) * RADIX_BITS;
+
+    size_t counts[RADIX_BUCKETS] = {0};
+    for (auto& key : keys) {
+      Uint64 digit = ((low ? key.mLow : key.mHigh) >> shift) & (RADIX_BUCKETS - 1);
+      counts[digit]++;
+    }
+
+    bool skip = false;
+    for (int b = 0; b < RADIX_BUCKETS; b++) {
+      if (counts[b] == keys.size()) {
+        skip = true;
+        break;
+      }
+    }
+    if (skip) {
+      continue;
+    }
+
+    size_t offset = 0;
+    for (int b = 0; b < RADIX_BUCKETS; b++) {
+      size_t count = counts[b];
+      counts[b] = offset;
+      offset += count;
+    }
+
+    for (auto& key : keys) {
+      Uint64 digit = ((low ? key.mLow : key.mHigh) >> shift) & (RADIX_BUCKETS - 1);
+      buffer[counts[digit]++] = key;
+    }
+    keys.swap(buffer);
+  }
+}
+
+/*
+ * sort rows in place by the (Uint64, Uint32) key returned by keyFunc. The
+ * sort is stable and moves every row exactly once.
+ */
+template<typename Row, typename KeyFunc>
+void radix_sort(std::vector<Row>& rows, KeyFunc keyFunc) {
+  if (rows.size() < 2) {
+    return;
+  }
+
+  std::vector<RadixKey> keys;
+  keys.reserve(rows.size());
+  for (Uint32 i = 0; i < rows.size(); i++) {
+    RadixKey key = keyFunc(rows[i]);
+    key.mIndex = i;
+    keys.push_back(key);
+  }
+
+  radix_sort_keys(keys);
+
+  std::vector<Row> sorted;
+  sorted.reserve(rows.size());
+  for (auto& key : keys) {
+    sorted.push_back(std::move(rows[key.mIndex]));
+  }
+  rows.swap(sorted);
+}
+
+#endif /* RADIXSORT_H */
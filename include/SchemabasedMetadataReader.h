@@ -42,10 +42,9 @@ private:
 class SchemabasedMetadataReaders : public NdbDataReaders<MetadataLogEntry, MConn>{
   public:
     SchemabasedMetadataReaders(MConn* connections, int num_readers, const bool hopsworks,
-          ProjectsElasticSearch* elastic, const int lru_cap) : NdbDataReaders(elastic){
+          ProjectsElasticSearch* elastic, const int lru_cap) : NdbDataReaders(elastic, "schemabased"){
       for(int i=0; i<num_readers; i++){
         SchemabasedMetadataReader* dr = new SchemabasedMetadataReader(connections[i], hopsworks, lru_cap);
-        dr->start(i, this);
         mDataReaders.push_back(dr);
       }
     }
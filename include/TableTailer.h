@@ -22,16 +22,47 @@
 
 #include "Utils.h"
 #include "tables/DBWatchTable.h"
+#include "MemoryAccounting.h"
+#include "ConcurrentQueue.h"
+#include "ConcurrentReorderWindow.h"
+#include "WatermarkGate.h"
+#include "EventHub.h"
+#include "EpochCheckpoint.h"
+#include "http/server/MetricsProvider.h"
 #include <mutex>
 #include <condition_variable>
+#include <map>
+#include <limits>
+#include <algorithm>
 
 enum Barrier {
   EPOCH = 0,
   GCI = 1
 };
 
+#define TAILER_DECODE_WINDOW 4096
+#define DEFAULT_RECOVERY_BATCH_ROWS 10000
+#define RECOVERY_DONE std::numeric_limits<Uint64>::max()
+
+/*
+ * Event buffer usage of a tailer, sampled by the poll thread after every
+ * poll since the Ndb object is not thread safe.
+ */
+struct EventBufferStats {
+  std::atomic<Uint64> mAllocatedBytes;
+  std::atomic<Uint64> mUsedBytes;
+  std::atomic<Uint32> mUsagePercent;
+  std::atomic<Uint64> mMaxAllocBytes;
+  std::atomic<Uint64> mHighestQueuedEpoch;
+  std::atomic<Uint64> mLastConsumedEpoch;
+
+  EventBufferStats() : mAllocatedBytes(0), mUsedBytes(0), mUsagePercent(0),
+  mMaxAllocBytes(0), mHighestQueuedEpoch(0), mLastConsumedEpoch(0) {
+  }
+};
+
 template<typename TableRow>
-class TableTailer {
+class TableTailer : public MetricsProvider, public EventSubscriber {
 public:
   TableTailer(Ndb* ndb, Ndb* recoveryNdb, DBWatchTable<TableRow>* table, const
   int poll_maxTimeToWait, const Barrier barrier);
@@ -39,8 +70,20 @@ public:
   TableTailer(Ndb* ndb, DBWatchTable<TableRow>* table, const
   int poll_maxTimeToWait, const Barrier barrier);
 
+  void setDecodeWorkers(const int decode_workers);
+  void setRecoveryBatchRows(const int recovery_batch_rows);
+  void setRecoveryScan(std::vector<Ndb*> connections, const int scan_batch);
+  void enableGapRecovery(Ndb* recoveryNdb);
+  void setEventHub(EventHub* hub);
+  void setCheckpoint(EpochCheckpoint* checkpoint);
   void start();
   void waitToFinish();
+  Uint32 getEventBufferUsagePercent() const;
+  std::string getMetrics() override;
+  void eventsPolled(Ndb* ndb) override;
+  void eventReceived(NdbEventOperation* op,
+      NdbDictionary::Event::TableEvent event) override;
+  void pollDone(Ndb* ndb) override;
   virtual ~TableTailer();
 
 protected:
@@ -52,9 +95,12 @@ protected:
 private:
   void createListenerEvent();
   void removeListenerEvent();
-  void waitForEvents();
-  void run();
+  void subscribe();
   void recover();
+  void recoverGap(Uint64 afterEpoch);
+  std::vector<Ndb*> getRecoveryConnections(Ndb* recoveryNdb);
+  void handleGap(Uint64 epoch, NdbDictionary::Event::TableEvent event);
+  void launchGapRecovery(Uint64 fromEpoch);
   const char* getEventName(NdbDictionary::Event::TableEvent event);
   Uint64 getGCI(Uint64 epoch);
   void checkIfBarrierReached(Uint64 epoch);
@@ -62,10 +108,65 @@ private:
       TableRow pre, TableRow row);
   void processEvent(Uint64 epoch, NdbDictionary::Event::TableEvent event,
       TableRow pre, TableRow row);
-  int processDeferredEvents();
+  void processSettledEvents(Uint64 settledEpoch);
+  void sampleEventBuffer(Ndb* ndb);
+  void processRecoveredEvents();
+  void firstPollHandled();
+
+  /*
+   * Events copied out of the ndb event buffer by the poll thread. Barriers
+   * and deferred event flushes travel in the same stream so the decode
+   * workers hand everything to the tailer in poll order.
+   */
+  struct StagedEvent {
+    enum Kind {
+      EVENT = 0,
+      BARRIER = 1,
+      RECOVERED = 2,
+      // ends the decode worker taking it, it is never published
+      STOP = 3
+    };
+    Kind mKind;
+    Uint64 mIndex;
+    Uint64 mEpoch;
+    // deferred events up to it can be handled, only set on barriers
+    Uint64 mSettledEpoch;
+    NdbDictionary::Event::TableEvent mEventType;
+    StagedRecAttr** mPreValues;
+    StagedRecAttr** mValues;
+    TableRow mPre;
+    TableRow mRow;
+  };
+
+  /*
+   * copies of the values of one staged event. The slot of an event is the
+   * one of the event TAILER_DECODE_WINDOW before it, the gate keeps fewer
+   * events in flight and releases them in staging order, so the slot is
+   * free again by then. The storage is sized for the largest values of
+   * the columns on the first use of the slot and reused after
+   */
+  struct StagingSlot {
+    std::vector<char> mStorage;
+    std::vector<StagedRecAttr> mAttrs;
+    std::vector<StagedRecAttr*> mValues;
+  };
+
+  void stageEvent(Uint64 epoch, NdbDictionary::Event::TableEvent eventType);
+  void stage(typename StagedEvent::Kind kind, Uint64 epoch,
+      NdbDictionary::Event::TableEvent eventType, Uint64 settledEpoch = 0);
+  StagingSlot& getStagingSlot(Uint64 index);
+  TableRow getRow(NdbRecAttr** values);
+  TableRow getRow(StagedRecAttr** values);
+  void stageRecovered(Uint64 epoch, TableRow row);
+  void decode();
+  void stopDecodeWorkers();
+  void dispatch(StagedEvent& staged);
 
   bool mStarted;
-  boost::thread mThread;
+  EventHub* mEventHub;
+  bool mOwnsEventHub;
+  NdbRecAttr** mValues;
+  NdbRecAttr** mPreValues;
   boost::thread mRecoveryThread;
 
   const std::string mEventName;
@@ -76,9 +177,12 @@ private:
   Uint64 mLastReportedBarrier;
 
   Ndb* mNdbRecoveryConnection;
-  bool mUnderRecovery;
+  std::atomic<bool> mUnderRecovery;
 
   Uint64 mFirstEpochToWatch;
+  // the events of the first poll, the only ones older than the first
+  // watched epoch, were deferred
+  bool mFirstPollHandled;
   std::mutex mFirstEpochMutex;
   std::condition_variable mFirstEpochCond;
 
@@ -86,24 +190,67 @@ private:
     NdbDictionary::Event::TableEvent mEventType;
     TableRow mPre;
     TableRow mRow;
+    typename TableRow::Key mPK;
   };
 
-  bool mStartProcessingDeferredEvents;
-  Uint64 mLastEpochInRecovery;
+  // the recovery handed out every row up to this epoch, RECOVERY_DONE once
+  // it finished
+  std::atomic<Uint64> mRecoveredThroughEpoch;
+  // highest epoch queued when polling, its events are all consumed by the
+  // end of the poll
+  Uint64 mPolledEpoch;
+
+  // guards the deferred events, recovery threads add to them concurrently
+  // with the live events
+  std::mutex mDeferredMutex;
+  Ndb* mNdbGapRecoveryConnection;
+  // epoch of the last event handed to handleEvent
+  std::atomic<Uint64> mLastAckedEpoch;
+  bool mGapRecoveryPending;
+  // last handled epoch when the earliest of the pending gaps happened
+  Uint64 mGapRecoveryFromEpoch;
+
+  struct RecoveredEpoch {
+    Uint64 mEpoch;
+    std::vector<TableRow> mRows;
+  };
 
-  boost::unordered_map<Uint64, std::queue<DeferredEvent>> mEventsDuringRecovery;
-  boost::unordered_set<std::string> mEventsPKDuringRecovery;
-  boost::unordered_set<Uint64> mEpochsDuringRecovery;
+  // recovered rows older than the first watched epoch, waiting for the
+  // poll thread. The gate bounds them to about mRecoveryBatchRows, if set
+  Uint32 mRecoveryBatchRows;
+  std::vector<Ndb*> mRecoveryScanConnections;
+  ConcurrentQueue<RecoveredEpoch> mRecovered;
+  WatermarkGate mRecoveredGate;
+
+  std::map<Uint64, std::queue<DeferredEvent>> mEventsDuringRecovery;
+  boost::unordered_set<typename TableRow::Key> mEventsPKDuringRecovery;
+
+  int mDecodeWorkers;
+  boost::thread_group mDecodeThreads;
+  ConcurrentQueue<StagedEvent>* mStaged;
+  std::vector<StagingSlot> mStagingSlots;
+  ConcurrentReorderWindow<StagedEvent>* mDecoded;
+  // staged events not yet handed to the tailer, bounds the staging queue
+  WatermarkGate mStagedGate;
+  Uint64 mStagedIndex;
+
+  EventBufferStats mEventBufferStats;
+  EpochCheckpoint* mCheckpoint;
 };
 
 template<typename TableRow>
 TableTailer<TableRow>::TableTailer(Ndb* ndb, Ndb* recoveryNdb, DBWatchTable<TableRow>* table,
     const int poll_maxTimeToWait, const Barrier barrier) : mNdbConnection(ndb), mStarted(false),
+mEventHub(nullptr), mOwnsEventHub(false), mValues(nullptr), mPreValues(nullptr),
 mEventName(Utils::concat("tail-", table->getName())), mTable(table),
 mPollMaxTimeToWait(poll_maxTimeToWait), mBarrier(barrier),
 mLastReportedBarrier(0), mNdbRecoveryConnection(recoveryNdb), mUnderRecovery(false),
-    mFirstEpochToWatch(0), mStartProcessingDeferredEvents(false),
-    mLastEpochInRecovery(0) {
+    mFirstEpochToWatch(0), mFirstPollHandled(false), mRecoveredThroughEpoch(0),
+    mPolledEpoch(0),
+    mNdbGapRecoveryConnection(nullptr),
+    mLastAckedEpoch(0), mGapRecoveryPending(false), mGapRecoveryFromEpoch(0),
+    mRecoveryBatchRows(DEFAULT_RECOVERY_BATCH_ROWS), mDecodeWorkers(0), mStaged(nullptr),
+    mDecoded(nullptr), mStagedIndex(0), mCheckpoint(nullptr) {
 }
 
 template<typename TableRow>
@@ -112,6 +259,71 @@ int poll_maxTimeToWait, const Barrier barrier) : TableTailer(ndb, nullptr, table
   
 }
 
+/*
+ * number of threads building rows out of the polled events, 0 builds them
+ * on the poll thread
+ */
+template<typename TableRow>
+void TableTailer<TableRow>::setDecodeWorkers(const int decode_workers) {
+  mDecodeWorkers = std::max(0, decode_workers);
+}
+
+/*
+ * rows the recovery reads back per round trip and queues at most for the
+ * poll thread, 0 reads RECOVERY_READ_BATCH rows per round trip and does
+ * not bound the queue
+ */
+template<typename TableRow>
+void TableTailer<TableRow>::setRecoveryBatchRows(const int recovery_batch_rows) {
+  mRecoveryBatchRows = std::max(0, recovery_batch_rows);
+}
+
+/*
+ * scan the partitions of the log table in parallel during recovery, one
+ * thread per connection. scan_batch is the number of rows per partition
+ * and round trip, 0 lets ndb decide
+ */
+template<typename TableRow>
+void TableTailer<TableRow>::setRecoveryScan(std::vector<Ndb*> connections,
+    const int scan_batch) {
+  mRecoveryScanConnections = connections;
+  mTable->setScanBatch(std::max(0, scan_batch));
+}
+
+template<typename TableRow>
+std::vector<Ndb*> TableTailer<TableRow>::getRecoveryConnections(Ndb* recoveryNdb) {
+  if (mRecoveryScanConnections.size() > 1) {
+    return mRecoveryScanConnections;
+  }
+  return std::vector<Ndb*>(1, recoveryNdb);
+}
+
+/*
+ * rescan the log table for the epochs lost when the event buffer overflows
+ * or reports an inconsistent epoch, instead of leaving them behind
+ */
+template<typename TableRow>
+void TableTailer<TableRow>::enableGapRecovery(Ndb* recoveryNdb) {
+  mNdbGapRecoveryConnection = recoveryNdb;
+}
+
+/*
+ * poll the events on a hub shared with other tables instead of a thread
+ * of its own, the hub is started by the caller once all tables subscribed
+ */
+template<typename TableRow>
+void TableTailer<TableRow>::setEventHub(EventHub* hub) {
+  mEventHub = hub;
+}
+
+/*
+ * track the rows handed on in the checkpoint, the recovery starts after it
+ */
+template<typename TableRow>
+void TableTailer<TableRow>::setCheckpoint(EpochCheckpoint* checkpoint) {
+  mCheckpoint = checkpoint;
+}
+
 template<typename TableRow>
 void TableTailer<TableRow>::start() {
   if (mStarted) {
@@ -119,8 +331,38 @@ void TableTailer<TableRow>::start() {
   }
 
   mUnderRecovery = mNdbRecoveryConnection != nullptr;
+  mRecoveredThroughEpoch = mUnderRecovery ? 0 : RECOVERY_DONE;
+  mRecoveredGate.setWatermarks(Watermarks(mRecoveryBatchRows,
+      mRecoveryBatchRows / 2));
   createListenerEvent();
-  mThread = boost::thread(&TableTailer::run, this);
+
+  if (mEventHub == nullptr) {
+    mEventHub = new EventHub(mNdbConnection, mPollMaxTimeToWait,
+        mTable->getName());
+    mOwnsEventHub = true;
+  } else if (mDecodeWorkers == 0) {
+    // the hub thread polls for other tables too, the events are queued for
+    // a worker of this table so a slow handleEvent does not hold them up
+    mDecodeWorkers = 1;
+  }
+  subscribe();
+
+  if (mDecodeWorkers > 0) {
+    mStaged = new ConcurrentQueue<StagedEvent>();
+    mStagingSlots.resize(TAILER_DECODE_WINDOW);
+    mDecoded = new ConcurrentReorderWindow<StagedEvent>(TAILER_DECODE_WINDOW);
+    mStagedGate.setWatermarks(Watermarks(TAILER_DECODE_WINDOW,
+        TAILER_DECODE_WINDOW / 2));
+    for (int i = 0; i < mDecodeWorkers; i++) {
+      mDecodeThreads.create_thread(boost::bind(&TableTailer::decode, this));
+    }
+    LOG_INFO(mTable->getName() << " decodes events on " << mDecodeWorkers
+        << " workers");
+  }
+
+  if (mOwnsEventHub) {
+    mEventHub->start();
+  }
 
   if(mUnderRecovery) {
     mRecoveryThread = boost::thread(&TableTailer::recover, this);
@@ -136,75 +378,154 @@ template<typename TableRow>
 void TableTailer<TableRow>::recover() {
   std::unique_lock<std::mutex> lk(mFirstEpochMutex);
   LOG_DEBUG("Waiting for the firstEpoch to start recovery for " << mTable->getName());
-  mFirstEpochCond.wait(lk, [this]{return mFirstEpochToWatch != 0;});
+  mFirstEpochCond.wait(lk, [this]{
+    return mFirstEpochToWatch != 0 && mFirstPollHandled;
+  });
   LOG_DEBUG(mTable->getName() << " recovery started for events before epoch "
   << mFirstEpochToWatch);
 
   ptime t1 = Utils::getCurrentTime();
 
-  EpochsRowsMap<TableRow> re = mTable->getAllForRecovery
-      (mNdbRecoveryConnection);
-
   int eventsApplied=0;
   int eventsToAdd=0;
   int alreadyExistsingEvents=0;
 
-  for (std::vector<Uint64>::iterator it = re.mEpochs->begin(); it !=
-      re.mEpochs->end(); it++) {
-    Uint64 epoch = *it;
-    std::queue<TableRow>* rows = re.mRowsByEpoch->at(epoch);
+  // rows up to the checkpoint were already sent, only their removal failed
+  Uint64 afterEpoch = 0;
+  if (mCheckpoint != nullptr) {
+    mCheckpoint->validate(mFirstEpochToWatch);
+    afterEpoch = mCheckpoint->getEpoch();
+  }
+  std::vector<Ndb*> connections = getRecoveryConnections(mNdbRecoveryConnection);
+  mTable->getAllForRecovery(connections, afterEpoch, mRecoveryBatchRows,
+      [&](Uint64 epoch, std::vector<TableRow>& rows) {
     if(epoch >= mFirstEpochToWatch){
-      while(!rows->empty()){
-        TableRow row = rows->front();
+      for (auto& row : rows) {
         //event is not in our deferred queue
         if(deferEvent(epoch, NdbDictionary::Event::TE_INSERT, row, row)){
           eventsToAdd++;
         }else{
           alreadyExistsingEvents++;
         }
-        rows->pop();
       }
     }else{
-      while(!rows->empty()){
-        TableRow row = rows->front();
-        deferEvent(epoch, NdbDictionary::Event::TE_INSERT, row, row);
-        rows->pop();
-        eventsApplied++;
+      // older than the first watched epoch, the poll thread handles them
+      // right away unless the first poll brought them as events already
+      {
+        std::lock_guard<std::mutex> lock(mDeferredMutex);
+        auto deferred = std::remove_if(rows.begin(), rows.end(),
+            [this](const TableRow& row) {
+          return mEventsPKDuringRecovery.find(mTable->getKey(row))
+              != mEventsPKDuringRecovery.end();
+        });
+        alreadyExistsingEvents += std::distance(deferred, rows.end());
+        rows.erase(deferred, rows.end());
+      }
+      if (!rows.empty()) {
+        eventsApplied += rows.size();
+        mRecoveredGate.acquire(rows.size());
+        mRecovered.push({epoch, std::move(rows)});
       }
     }
-    delete rows;
-  }
-
-  delete re.mEpochs;
-  delete re.mRowsByEpoch;
+    mRecoveredThroughEpoch = epoch;
+  });
 
-  mStartProcessingDeferredEvents = true;
+  mRecoveredThroughEpoch = RECOVERY_DONE;
 
   ptime t2 = Utils::getCurrentTime();
   LOG_INFO(mTable->getName() << " recovery done in " <<
   Utils::getTimeDiffInMilliseconds(t1, t2) << " msec : " << eventsApplied
   << " old events recovered, " << alreadyExistsingEvents
   << " already captured events, " << eventsToAdd
-  << " concurrent events during recovery, " <<
-  (eventsApplied + eventsToAdd)
-  << " total number of events added to deferred events.");
+  << " concurrent events during recovery added to deferred events.");
 }
 
+/*
+ * only rows written after the last handled epoch are deferred, the live
+ * events keep being deferred meanwhile and both are merged the same way as
+ * after the initial recovery
+ */
 template<typename TableRow>
-void TableTailer<TableRow>::waitToFinish() {
-  if (mStarted) {
-    mThread.join();
-  }
+void TableTailer<TableRow>::recoverGap(Uint64 afterEpoch) {
+  LOG_INFO(mTable->getName() << " gap recovery started for events after epoch "
+      << afterEpoch);
+  ptime t1 = Utils::getCurrentTime();
+
+  int eventsToAdd = 0;
+  int alreadyExistsingEvents = 0;
+  std::vector<Ndb*> connections = getRecoveryConnections(mNdbGapRecoveryConnection);
+  mTable->getAllForRecovery(connections, afterEpoch,
+      mRecoveryBatchRows, [&](Uint64 epoch, std::vector<TableRow>& rows) {
+    for (auto& row : rows) {
+      if (deferEvent(epoch, NdbDictionary::Event::TE_INSERT, row, row)) {
+        eventsToAdd++;
+      } else {
+        alreadyExistsingEvents++;
+      }
+    }
+    mRecoveredThroughEpoch = epoch;
+  });
+
+  mRecoveredThroughEpoch = RECOVERY_DONE;
+
+  ptime t2 = Utils::getCurrentTime();
+  LOG_INFO(mTable->getName() << " gap recovery done in " <<
+  Utils::getTimeDiffInMilliseconds(t1, t2) << " msec : " << eventsToAdd
+  << " events recovered, " << alreadyExistsingEvents
+  << " already captured events");
 }
 
 template<typename TableRow>
-void TableTailer<TableRow>::run() {
-  try {
-    waitForEvents();
-  } catch (boost::thread_interrupted&) {
-    LOG_ERROR("Thread is stopped");
+void TableTailer<TableRow>::handleGap(Uint64 epoch,
+    NdbDictionary::Event::TableEvent event) {
+  // the rows lost are the ones after what was handled when the gap showed
+  Uint64 gapEpoch = mLastAckedEpoch;
+  if (mNdbGapRecoveryConnection == nullptr) {
+    // nothing would ever release a hold, the checkpoint goes on past them
+    LOG_ERROR(mTable->getName() << " lost events in epoch " << epoch << " ["
+        << getEventName(event) << "], gap recovery is disabled");
     return;
   }
+  if (mCheckpoint != nullptr) {
+    // the lost rows are not tracked, keep them in the next recovery until
+    // the gap recovery handed them on
+    mCheckpoint->hold(gapEpoch);
+  }
+
+  LOG_WARN(mTable->getName() << " lost events in epoch " << epoch << " ["
+      << getEventName(event) << "], last handled epoch " << gapEpoch);
+  std::lock_guard<std::mutex> lock(mDeferredMutex);
+  if (mUnderRecovery) {
+    // the running scan may have passed the lost rows already. The events
+    // keep being handled until it is over, so the epoch is kept from now
+    mGapRecoveryFromEpoch = mGapRecoveryPending
+        ? std::min(mGapRecoveryFromEpoch, gapEpoch) : gapEpoch;
+    mGapRecoveryPending = true;
+    return;
+  }
+  launchGapRecovery(gapEpoch);
+}
+
+/*
+ * has to be called holding mDeferredMutex
+ */
+template<typename TableRow>
+void TableTailer<TableRow>::launchGapRecovery(Uint64 fromEpoch) {
+  mUnderRecovery = true;
+  mRecoveredThroughEpoch = fromEpoch;
+  mGapRecoveryPending = false;
+  if (mRecoveryThread.joinable()) {
+    // the previous recovery is done once its deferred events were processed
+    mRecoveryThread.join();
+  }
+  mRecoveryThread = boost::thread(&TableTailer::recoverGap, this, fromEpoch);
+}
+
+template<typename TableRow>
+void TableTailer<TableRow>::waitToFinish() {
+  if (mStarted && mOwnsEventHub) {
+    mEventHub->waitToFinish();
+  }
 }
 
 template<typename TableRow>
@@ -221,8 +542,9 @@ void TableTailer<TableRow>::createListenerEvent() {
     myEvent.addTableEvent(mTable->getEvent(i));
   }
 
-  myEvent.addEventColumns(mTable->getNoColumns(), mTable->getColumns());
-  //myEvent.mergeEvents(merge_events);
+  std::vector<const char*> columns = mTable->getColumns();
+  myEvent.addEventColumns(columns.size(), columns.data());
+  myEvent.mergeEvents(mTable->isEventMergingEnabled());
 
   // Add event to database
   if (myDict->createEvent(myEvent) == 0) {
@@ -252,93 +574,386 @@ void TableTailer<TableRow>::removeListenerEvent() {
 }
 
 template<typename TableRow>
-void TableTailer<TableRow>::waitForEvents() {
+void TableTailer<TableRow>::subscribe() {
+  Ndb* ndb = mEventHub->getNdb();
   NdbEventOperation* op;
   LOG_INFO("create EventOperation for [" << mEventName << "]");
-  if ((op = mNdbConnection->createEventOperation(mEventName.c_str())) == NULL)
-    LOG_NDB_API_FATAL(mTable->getName(), mNdbConnection->getNdbError());
+  if ((op = ndb->createEventOperation(mEventName.c_str())) == NULL)
+    LOG_NDB_API_FATAL(mTable->getName(), ndb->getNdbError());
 
-  NdbRecAttr * recAttr[mTable->getNoColumns()];
-  NdbRecAttr * recAttrPre[mTable->getNoColumns()];
+  // only ask for the images the watched events need, the other rows are
+  // passed on default constructed
+  if (mTable->needsPostImage()) {
+    mValues = new NdbRecAttr*[mTable->getNoColumns()];
+  }
+  if (mTable->needsPreImage()) {
+    mPreValues = new NdbRecAttr*[mTable->getNoColumns()];
+  }
 
   // primary keys should always be a part of the result
   for (strvec_size_type i = 0; i < mTable->getNoColumns(); i++) {
-    recAttr[i] = op->getValue(mTable->getColumn(i).c_str());
-    recAttrPre[i] = op->getPreValue(mTable->getColumn(i).c_str());
+    if (mValues != nullptr) {
+      mValues[i] = op->getValue(mTable->getColumn(i).c_str());
+    }
+    if (mPreValues != nullptr) {
+      mPreValues[i] = op->getPreValue(mTable->getColumn(i).c_str());
+    }
   }
+  op->mergeEvents(mTable->isEventMergingEnabled());
 
   LOG_INFO("Execute");
   // This starts changes to "start flowing"
   if (op->execute())
     LOG_NDB_API_FATAL(mTable->getName(), op->getNdbError());
-  while (true) {
-    int r = mNdbConnection->pollEvents2(mPollMaxTimeToWait);
-
-    if (mFirstEpochToWatch == 0) {
-      std::unique_lock<std::mutex> lk(mFirstEpochMutex);
-      mFirstEpochToWatch = mNdbConnection->getHighestQueuedEpoch();
-      lk.unlock();
-      LOG_DEBUG(mTable->getName() << " firstEpoch to watch "
-                                  << mFirstEpochToWatch);
-      mFirstEpochCond.notify_all();
-    }
+  mEventHub->subscribe(op, this);
+}
 
-    if (mStartProcessingDeferredEvents) {
-      if(mLastEpochInRecovery == 0 && !mEpochsDuringRecovery.empty()){
-        std::vector<Uint64> orderedEpochs;
-        orderedEpochs.insert(orderedEpochs.end(), mEpochsDuringRecovery.begin(), mEpochsDuringRecovery.end());
-        std::sort(orderedEpochs.begin(), orderedEpochs.end());
-        mLastEpochInRecovery = orderedEpochs[orderedEpochs.size() - 1];
-      }
+template<typename TableRow>
+void TableTailer<TableRow>::eventsPolled(Ndb* ndb) {
+  sampleEventBuffer(ndb);
+
+  if (mFirstEpochToWatch == 0) {
+    std::unique_lock<std::mutex> lk(mFirstEpochMutex);
+    mFirstEpochToWatch = ndb->getHighestQueuedEpoch();
+    lk.unlock();
+    LOG_DEBUG(mTable->getName() << " firstEpoch to watch "
+                                << mFirstEpochToWatch);
+    mFirstEpochCond.notify_all();
+  }
+
+  mPolledEpoch = ndb->getHighestQueuedEpoch();
+}
 
-      if(mNdbConnection->getHighestQueuedEpoch() > mLastEpochInRecovery) {
-        ptime t1 = Utils::getCurrentTime();
-        int deferredEventsProcessed = processDeferredEvents();
-        ptime t2 = Utils::getCurrentTime();
-        LOG_INFO(mTable->getName()
-                     << " processing deferred events and recovered events in "
-                     << Utils::getTimeDiffInMilliseconds(t1, t2)
-                     << " msec " << deferredEventsProcessed
-                     << " events processed");
-      }else{
-        LOG_INFO(mTable->getName()
-        << " defer events since the seen epoch during recovery (" <<
-        mLastEpochInRecovery << ") is higher than the current received epoch ("
-        << mNdbConnection->getHighestQueuedEpoch() << ")");
+template<typename TableRow>
+void TableTailer<TableRow>::eventReceived(NdbEventOperation* op,
+    NdbDictionary::Event::TableEvent event) {
+  mEventBufferStats.mLastConsumedEpoch = op->getEpoch();
+
+  if (event != NdbDictionary::Event::TE_EMPTY) {
+    LOG_TRACE("Got Event [" << event << "," << getEventName(event) << "] Epoch " << op->getEpoch() << " GCI " << getGCI(op->getEpoch()));
+  }
+  switch (event) {
+    case NdbDictionary::Event::TE_INSERT:
+    case NdbDictionary::Event::TE_DELETE:
+    case NdbDictionary::Event::TE_UPDATE: {
+
+      if (mDecodeWorkers > 0) {
+        // the values are only valid until the next event, copy them
+        // and leave building the rows to the decode workers
+        stageEvent(op->getEpoch(), event);
+      } else if (mUnderRecovery) {
+        deferEvent(op->getEpoch(), event, getRow(mPreValues),
+            getRow(mValues));
+      } else {
+        processEvent(op->getEpoch(), event, getRow(mPreValues),
+            getRow(mValues));
       }
+      break;
     }
+    case NdbDictionary::Event::TE_OUT_OF_MEMORY:
+    case NdbDictionary::Event::TE_INCONSISTENT:
+      handleGap(op->getEpoch(), event);
+      break;
+    default:
+      break;
+  }
+}
 
-    if (r > 0) {
-      while ((op = mNdbConnection->nextEvent2())) {
-        NdbDictionary::Event::TableEvent event = op->getEventType2();
+/*
+ * a deferred epoch is settled once both the recovery and the events went
+ * past it, settled epochs are handled every poll so the events take over
+ * from the recovery without stopping
+ */
+template<typename TableRow>
+void TableTailer<TableRow>::pollDone(Ndb* ndb) {
+  // every epoch queued when the poll started was taken out of the buffer,
+  // also on a table without events
+  if (mPolledEpoch > mEventBufferStats.mLastConsumedEpoch) {
+    mEventBufferStats.mLastConsumedEpoch = mPolledEpoch;
+  }
+  Uint64 settledEpoch = std::min(mRecoveredThroughEpoch.load(), mPolledEpoch);
+  // read after the settled epoch, so the recovered rows up to it are queued
+  processRecoveredEvents();
 
-        if (event != NdbDictionary::Event::TE_EMPTY) {
-          LOG_TRACE("Got Event [" << event << "," << getEventName(event) << "] Epoch " << op->getEpoch() << " GCI " << getGCI(op->getEpoch()));
-        }
-        switch (event) {
-          case NdbDictionary::Event::TE_INSERT:
-          case NdbDictionary::Event::TE_DELETE:
-          case NdbDictionary::Event::TE_UPDATE: {
-
-            if (mUnderRecovery) {
-              deferEvent(op->getEpoch(), event, mTable->getRow(recAttrPre),
-                  mTable->getRow(recAttr));
-            } else {
-              processEvent(op->getEpoch(), event, mTable->getRow(recAttrPre),
-                  mTable->getRow(recAttr));
-            }
-            break;
-          }
-          default:
-            break;
-        }
+  if (mDecodeWorkers > 0) {
+    stage(StagedEvent::BARRIER, ndb->getHighestQueuedEpoch(),
+        NdbDictionary::Event::TE_EMPTY, settledEpoch);
+  } else {
+    if (mUnderRecovery) {
+      processSettledEvents(settledEpoch);
+    }
+    checkIfBarrierReached(ndb->getHighestQueuedEpoch());
+    if (mCheckpoint != nullptr) {
+      mCheckpoint->handedOut(settledEpoch);
+    }
+    firstPollHandled();
+  }
+}
+
+template<typename TableRow>
+void TableTailer<TableRow>::firstPollHandled() {
+  if (mFirstPollHandled) {
+    return;
+  }
+  std::unique_lock<std::mutex> lk(mFirstEpochMutex);
+  mFirstPollHandled = true;
+  lk.unlock();
+  mFirstEpochCond.notify_all();
+}
+
+/*
+ * blocks while TAILER_DECODE_WINDOW events are staged and not yet handled
+ */
+template<typename TableRow>
+void TableTailer<TableRow>::stageEvent(Uint64 epoch,
+    NdbDictionary::Event::TableEvent eventType) {
+  mStagedGate.acquire(1);
+  StagedEvent staged;
+  staged.mKind = StagedEvent::EVENT;
+  staged.mIndex = ++mStagedIndex;
+  staged.mEpoch = epoch;
+  staged.mSettledEpoch = 0;
+  staged.mEventType = eventType;
+  staged.mPreValues = nullptr;
+  staged.mValues = nullptr;
+
+  StagingSlot& slot = getStagingSlot(staged.mIndex);
+  const strvec_size_type noColumns = mTable->getNoColumns();
+  for (strvec_size_type i = 0; i < noColumns; i++) {
+    if (mPreValues != nullptr) {
+      slot.mAttrs[i].assign(mPreValues[i]);
+    }
+    if (mValues != nullptr) {
+      slot.mAttrs[noColumns + i].assign(mValues[i]);
+    }
+  }
+  if (mPreValues != nullptr) {
+    staged.mPreValues = slot.mValues.data();
+  }
+  if (mValues != nullptr) {
+    staged.mValues = slot.mValues.data() + noColumns;
+  }
+  mStaged->push(staged);
+}
+
+template<typename TableRow>
+void TableTailer<TableRow>::stage(typename StagedEvent::Kind kind,
+    Uint64 epoch, NdbDictionary::Event::TableEvent eventType,
+    Uint64 settledEpoch) {
+  mStagedGate.acquire(1);
+  StagedEvent staged;
+  staged.mKind = kind;
+  staged.mIndex = ++mStagedIndex;
+  staged.mEpoch = epoch;
+  staged.mSettledEpoch = settledEpoch;
+  staged.mEventType = eventType;
+  staged.mPreValues = nullptr;
+  staged.mValues = nullptr;
+  mStaged->push(staged);
+}
+
+/*
+ * the pre values of the columns come first in a slot, then the post
+ * values, each in storage for the largest value of its column
+ */
+template<typename TableRow>
+typename TableTailer<TableRow>::StagingSlot&
+TableTailer<TableRow>::getStagingSlot(Uint64 index) {
+  StagingSlot& slot = mStagingSlots[index % mStagingSlots.size()];
+  if (!slot.mAttrs.empty()) {
+    return slot;
+  }
+  NdbRecAttr** recAttrs = mValues != nullptr ? mValues : mPreValues;
+  if (recAttrs == nullptr) {
+    return slot;
+  }
+  const strvec_size_type noColumns = mTable->getNoColumns();
+  std::vector<Uint32> capacities(noColumns);
+  std::size_t rowBytes = 0;
+  for (strvec_size_type i = 0; i < noColumns; i++) {
+    capacities[i] = (recAttrs[i]->getColumn()->getSizeInBytes() + 7) & ~7;
+    rowBytes += capacities[i];
+  }
+  slot.mStorage.resize(2 * rowBytes);
+  slot.mAttrs.resize(2 * noColumns);
+  slot.mValues.resize(2 * noColumns);
+  std::size_t offset = 0;
+  for (std::size_t i = 0; i < slot.mAttrs.size(); i++) {
+    Uint32 capacity = capacities[i % noColumns];
+    slot.mAttrs[i].bind(recAttrs[i % noColumns]->getColumn(),
+        slot.mStorage.data() + offset, capacity);
+    slot.mValues[i] = &slot.mAttrs[i];
+    offset += capacity;
+  }
+  return slot;
+}
+
+template<typename TableRow>
+void TableTailer<TableRow>::stageRecovered(Uint64 epoch, TableRow row) {
+  mStagedGate.acquire(1);
+  StagedEvent staged;
+  staged.mKind = StagedEvent::RECOVERED;
+  staged.mIndex = ++mStagedIndex;
+  staged.mEpoch = epoch;
+  staged.mSettledEpoch = 0;
+  staged.mEventType = NdbDictionary::Event::TE_INSERT;
+  staged.mPreValues = nullptr;
+  staged.mValues = nullptr;
+  staged.mPre = row;
+  staged.mRow = row;
+  mStaged->push(staged);
+}
 
+template<typename TableRow>
+TableRow TableTailer<TableRow>::getRow(NdbRecAttr** values) {
+  if (values == nullptr) {
+    return TableRow();
+  }
+  return mTable->getRow(values);
+}
+
+template<typename TableRow>
+TableRow TableTailer<TableRow>::getRow(StagedRecAttr** values) {
+  if (values == nullptr) {
+    return TableRow();
+  }
+  return mTable->getRow(values);
+}
+
+template<typename TableRow>
+void TableTailer<TableRow>::decode() {
+  while (true) {
+    StagedEvent staged;
+    mStaged->wait_and_pop(staged);
+    if (staged.mKind == StagedEvent::STOP) {
+      return;
+    }
+    if (staged.mKind == StagedEvent::EVENT) {
+      staged.mPre = getRow(staged.mPreValues);
+      staged.mRow = getRow(staged.mValues);
+    }
+    // the window hands the events over in staging order, one at a time
+    mDecoded->publish(staged.mIndex, std::move(staged), [this](StagedEvent& e) {
+      dispatch(e);
+      mStagedGate.release(1);
+    });
+  }
+}
+
+template<typename TableRow>
+void TableTailer<TableRow>::dispatch(StagedEvent& staged) {
+  switch (staged.mKind) {
+    case StagedEvent::EVENT:
+      if (mUnderRecovery) {
+        deferEvent(staged.mEpoch, staged.mEventType, staged.mPre, staged.mRow);
+      } else {
+        processEvent(staged.mEpoch, staged.mEventType, staged.mPre,
+            staged.mRow);
+      }
+      break;
+    case StagedEvent::BARRIER:
+      if (mUnderRecovery) {
+        processSettledEvents(staged.mSettledEpoch);
+      }
+      checkIfBarrierReached(staged.mEpoch);
+      if (mCheckpoint != nullptr) {
+        mCheckpoint->handedOut(staged.mSettledEpoch);
+      }
+      firstPollHandled();
+      break;
+    case StagedEvent::RECOVERED:
+      processEvent(staged.mEpoch, staged.mEventType, staged.mPre, staged.mRow);
+      break;
+    case StagedEvent::STOP:
+      break;
+  }
+}
+
+/*
+ * the workers finish the events staged before they are stopped, so none is
+ * left half handed over in the window
+ */
+template<typename TableRow>
+void TableTailer<TableRow>::stopDecodeWorkers() {
+  if (mStaged == nullptr) {
+    return;
+  }
+  for (int i = 0; i < mDecodeWorkers; i++) {
+    StagedEvent stop;
+    stop.mKind = StagedEvent::STOP;
+    stop.mIndex = 0;
+    mStaged->push(stop);
+  }
+  mDecodeThreads.join_all();
+  delete mStaged;
+  delete mDecoded;
+  mStaged = nullptr;
+  mDecoded = nullptr;
+  mStagingSlots.clear();
+  mStagingSlots.shrink_to_fit();
+}
+
+/*
+ * recovered rows older than the first watched epoch come in epoch order
+ * and before all events, so they are handled while the recovery goes on
+ */
+template<typename TableRow>
+void TableTailer<TableRow>::processRecoveredEvents() {
+  RecoveredEpoch recovered;
+  while (mRecovered.try_pop(recovered)) {
+    for (auto& row : recovered.mRows) {
+      if (mDecodeWorkers > 0) {
+        stageRecovered(recovered.mEpoch, row);
+      } else {
+        processEvent(recovered.mEpoch, NdbDictionary::Event::TE_INSERT, row,
+            row);
       }
     }
-    //        boost::this_thread::sleep(boost::posix_time::milliseconds(mPollMaxTimeToWait));
-    checkIfBarrierReached(mNdbConnection->getHighestQueuedEpoch());
+    mRecoveredGate.release(recovered.mRows.size());
   }
+}
 
+template<typename TableRow>
+void TableTailer<TableRow>::sampleEventBuffer(Ndb* ndb) {
+  Ndb::EventBufferMemoryUsage usage;
+  ndb->get_event_buffer_memory_usage(usage);
+  mEventBufferStats.mAllocatedBytes = usage.allocated_bytes;
+  mEventBufferStats.mUsedBytes = usage.used_bytes;
+  mEventBufferStats.mUsagePercent = usage.usage_percent;
+  mEventBufferStats.mMaxAllocBytes = ndb->get_eventbuf_max_alloc();
+  mEventBufferStats.mHighestQueuedEpoch = ndb->getHighestQueuedEpoch();
+  if (mEventBufferStats.mLastConsumedEpoch == 0) {
+    mEventBufferStats.mLastConsumedEpoch = mEventBufferStats.mHighestQueuedEpoch.load();
+  }
+}
+
+/*
+ * fill level of the event buffer, 0 while its size is unlimited
+ */
+template<typename TableRow>
+Uint32 TableTailer<TableRow>::getEventBufferUsagePercent() const {
+  return mEventBufferStats.mUsagePercent;
+}
+
+template<typename TableRow>
+std::string TableTailer<TableRow>::getMetrics() {
+  std::stringstream out;
+  std::string label = "{table=\"" + mTable->getName() + "\"} ";
+  Uint64 highest = mEventBufferStats.mHighestQueuedEpoch;
+  Uint64 consumed = mEventBufferStats.mLastConsumedEpoch;
+  Uint64 gciGap = highest > consumed ? getGCI(highest) - getGCI(consumed) : 0;
+  out << "epipe_tailer_eventbuffer_allocated_bytes" << label
+      << mEventBufferStats.mAllocatedBytes << std::endl;
+  out << "epipe_tailer_eventbuffer_used_bytes" << label
+      << mEventBufferStats.mUsedBytes << std::endl;
+  out << "epipe_tailer_eventbuffer_usage_percent" << label
+      << mEventBufferStats.mUsagePercent << std::endl;
+  out << "epipe_tailer_eventbuffer_max_alloc_bytes" << label
+      << mEventBufferStats.mMaxAllocBytes << std::endl;
+  out << "epipe_tailer_highest_queued_epoch" << label << highest << std::endl;
+  out << "epipe_tailer_last_consumed_epoch" << label << consumed << std::endl;
+  out << "epipe_tailer_gci_lag" << label << gciGap << std::endl;
+  return out.str();
 }
 
 template<typename TableRow>
@@ -411,20 +1026,15 @@ void TableTailer<TableRow>::checkIfBarrierReached(Uint64 epoch) {
 template<typename TableRow>
 bool TableTailer<TableRow>::deferEvent(Uint64 epoch,
     NdbDictionary::Event::TableEvent event, TableRow pre, TableRow row) {
+  std::lock_guard<std::mutex> lock(mDeferredMutex);
+  typename TableRow::Key pk = mTable->getKey(row);
   //event already exists
-  if(mEventsPKDuringRecovery.find(mTable->getPKStr(row)) !=
-     mEventsPKDuringRecovery.end()){
+  if(mEventsPKDuringRecovery.find(pk) != mEventsPKDuringRecovery.end()){
     return false;
   }
 
-  if(mEventsDuringRecovery.find(epoch) == mEventsDuringRecovery
-      .end()){
-    mEventsDuringRecovery[epoch] = std::queue<DeferredEvent>();
-  }
-
-  mEventsDuringRecovery[epoch].push({event, pre, row});
-  mEventsPKDuringRecovery.insert(mTable->getPKStr(row));
-  mEpochsDuringRecovery.insert(epoch);
+  mEventsDuringRecovery[epoch].push({event, pre, row, pk});
+  mEventsPKDuringRecovery.insert(pk);
   return true;
 }
 
@@ -432,35 +1042,72 @@ template<typename TableRow>
 void TableTailer<TableRow>::processEvent(Uint64 epoch,
     NdbDictionary::Event::TableEvent event, TableRow pre, TableRow row) {
   checkIfBarrierReached(epoch);
+  if (mCheckpoint != nullptr) {
+    mTable->setEpoch(row, epoch);
+    mCheckpoint->track(epoch);
+  }
   handleEvent(event, pre, row);
+  mLastAckedEpoch = epoch;
 }
 
+/*
+ * handles the deferred epochs up to settledEpoch in epoch order. Their keys
+ * are forgotten, neither the recovery nor the events can bring them again.
+ * The recovery is over once it is done and nothing is deferred anymore
+ */
 template<typename TableRow>
-int TableTailer<TableRow>::processDeferredEvents() {
-  int deferredEvents = 0;
-  std::vector<Uint64> orderedEpochs;
-  orderedEpochs.insert(orderedEpochs.end(), mEpochsDuringRecovery.begin(), mEpochsDuringRecovery.end());
-  std::sort(orderedEpochs.begin(), orderedEpochs.end());
+void TableTailer<TableRow>::processSettledEvents(Uint64 settledEpoch) {
+  std::map<Uint64, std::queue<DeferredEvent>> settled;
+  {
+    std::lock_guard<std::mutex> lock(mDeferredMutex);
+    auto end = mEventsDuringRecovery.upper_bound(settledEpoch);
+    for (auto it = mEventsDuringRecovery.begin(); it != end; ++it) {
+      settled.emplace(it->first, std::move(it->second));
+    }
+    mEventsDuringRecovery.erase(mEventsDuringRecovery.begin(), end);
+  }
 
-  for(auto& epoch : orderedEpochs){
-    std::queue<DeferredEvent>& q = mEventsDuringRecovery[epoch];
-    while(!q.empty()){
-      DeferredEvent e = q.front();
-      processEvent(epoch, e.mEventType, e.mPre, e.mRow);
+  int settledEvents = 0;
+  for (auto& epochEvents : settled) {
+    std::queue<DeferredEvent>& q = epochEvents.second;
+    while (!q.empty()) {
+      DeferredEvent& e = q.front();
+      processEvent(epochEvents.first, e.mEventType, e.mPre, e.mRow);
+      {
+        std::lock_guard<std::mutex> lock(mDeferredMutex);
+        mEventsPKDuringRecovery.erase(e.mPK);
+      }
       q.pop();
-      deferredEvents++;
+      settledEvents++;
+    }
+  }
+  if (settledEvents > 0) {
+    LOG_DEBUG(mTable->getName() << " handled " << settledEvents
+        << " deferred events up to epoch " << settledEpoch);
+  }
+
+  std::lock_guard<std::mutex> lock(mDeferredMutex);
+  if (mRecoveredThroughEpoch == RECOVERY_DONE
+      && mEventsDuringRecovery.empty()) {
+    mEventsPKDuringRecovery.clear();
+    mUnderRecovery = false;
+    LOG_INFO(mTable->getName() << " recovery caught up with the events");
+    if (mGapRecoveryPending) {
+      launchGapRecovery(mGapRecoveryFromEpoch);
+    } else if (mCheckpoint != nullptr && mNdbGapRecoveryConnection != nullptr) {
+      mCheckpoint->release();
     }
   }
-  mEventsPKDuringRecovery.clear();
-  mEventsDuringRecovery.clear();
-  mEpochsDuringRecovery.clear();
-  mUnderRecovery = false;
-  mStartProcessingDeferredEvents = false;
-  return deferredEvents;
 }
 
 template<typename TableRow>
 TableTailer<TableRow>::~TableTailer() {
+  if (mOwnsEventHub) {
+    delete mEventHub;
+  }
+  stopDecodeWorkers();
+  delete[] mValues;
+  delete[] mPreValues;
   delete mNdbConnection;
 }
 #endif /* TABLETAILER_H */
@@ -23,6 +23,8 @@
 #include "rapidjson/document.h"
 #include "Utils.h"
 #include "ConcurrentQueue.h"
+#include "WatermarkGate.h"
+#include "MemoryAccounting.h"
 #include "tables/DBTableBase.h"
 #include "http/HttpClient.h"
 #include "tables/DBWatchTable.h"
@@ -93,9 +95,9 @@ private:
 };
 
 struct eBulk {
-  Uint64 mProcessingIndex;
+  Uint64 mProcessingIndex = 0;
   std::deque<eEvent> mEvents;
-  Uint32 mJSONLength;
+  Uint32 mJSONLength = 0;
   ptime mStartProcessing;
   ptime mEndProcessing;
 
@@ -126,6 +128,11 @@ struct eBulk {
     }
   }
 
+  Uint64 getByteSize() const{
+    return sizeof(eBulk) + mJSONLength + mEvents.size() * (sizeof(eEvent)
+        + sizeof(ptime) + sizeof(const LogHandler*));
+  }
+
   std::string batchJSON(){
     std::string out;
     for(auto e : mEvents){
@@ -206,9 +213,11 @@ struct ParsingResponse{
 
 class TimedRestBatcher : public Batcher {
 public:
-  TimedRestBatcher(const HttpClientConfig elastic_client_config, int time_to_wait_before_inserting, int bulk_size);
+  TimedRestBatcher(const HttpClientConfig elastic_client_config, int time_to_wait_before_inserting, int bulk_size,
+      const std::string pipe);
 
   void addData(eBulk data);
+  void setWatermarks(const Watermarks watermarks);
   
   void shutdown();
   
@@ -217,7 +226,8 @@ public:
 protected:
   bool mElasticConnetionFailed;
   ptime mTimeElasticConnectionFailed;
-  Uint32 mCurrentQueueSize;
+
+  Uint32 getPendingEvents();
 
   ParsingResponse httpPostRequest(std::string requestUrl, std::string json);
   ParsingResponse httpDeleteRequest(std::string requestUrl);
@@ -228,15 +238,22 @@ protected:
 
 private:
   ConcurrentQueue<eBulk> mQueue;
+  // events added and not yet sent to elastic
+  WatermarkGate mPendingEvents;
+  // bulks added and not yet sent to elastic
+  MemoryAccount* mPendingBytes;
   std::vector<eBulk>* mToProcess;
   int mToProcessLength;
   boost::mutex mLock;
   bool mShutdown;
   HttpClient mHttpClient;
   int mToProcessEvents;
+  Uint64 mToProcessBytes;
+  Int64 mFirstPendingUs;
 
   virtual void run();
   virtual void processBatch();
+  virtual void timerExpired();
 
   enum HttpVerb{
     POST,
@@ -0,0 +1,112 @@
+/*
+ * This file is part of ePipe
+ * Copyright (C) 2019, Logical Clocks AB. All rights reserved
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include "Utils.h"
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+#define TIMER_WHEEL_TICK_MS 10
+#define TIMER_WHEEL_LEVELS 4
+#define TIMER_WHEEL_SLOT_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_SLOT_BITS)
+
+struct TimerNode {
+  TimerNode* mPrev;
+  TimerNode* mNext;
+
+  TimerNode() : mPrev(this), mNext(this) {
+  }
+
+  bool linked() const {
+    return mNext != this;
+  }
+
+  void unlink() {
+    mPrev->mNext = mNext;
+    mNext->mPrev = mPrev;
+    mPrev = this;
+    mNext = this;
+  }
+
+  void append(TimerNode* node) {
+    node->mPrev = mPrev;
+    node->mNext = this;
+    mPrev->mNext = node;
+    mPrev = node;
+  }
+};
+
+/*
+ * A periodic timer owned by its user and linked into the wheel in place,
+ * so arming, resetting and firing never allocate.
+ */
+class Timer : private TimerNode {
+public:
+  Timer(std::function<void()> callback);
+
+private:
+  friend class TimerWheel;
+  std::function<void()> mCallback;
+  Uint64 mExpiry;
+  int mIntervalTicks;
+  bool mScheduled;
+  bool mFiring;
+};
+
+/*
+ * Process wide hierarchical timer wheel serving the flush deadlines of all
+ * batchers from a single thread. Callbacks run on the wheel thread and should
+ * not block.
+ */
+class TimerWheel {
+public:
+  static TimerWheel& getInstance();
+
+  void start(Timer* timer, int first_delay_ms, int interval_ms);
+  void reset(Timer* timer);
+  void cancel(Timer* timer);
+
+private:
+  TimerWheel();
+  TimerWheel(TimerWheel const&);
+  void operator=(TimerWheel const&);
+
+  void run();
+  void advance();
+  void cascade(int level);
+  void insert(Timer* timer, Uint64 expiry);
+  void fireExpired();
+  Uint64 toTicks(int delay_ms);
+
+  std::mutex mLock;
+  std::condition_variable mFired;
+  boost::thread mThread;
+  std::chrono::steady_clock::time_point mStartTime;
+  Uint64 mCurrentTick;
+
+  TimerNode mSlots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+  TimerNode mExpired;
+};
+
+#endif /* TIMERWHEEL_H */
@@ -24,6 +24,7 @@
 #include "Logger.h"
 #include<cstdlib>
 #include<cstring>
+#include<chrono>
 
 typedef boost::posix_time::ptime ptime;
 
@@ -50,6 +51,21 @@ namespace Utils {
    return getTimeDiffInMilliseconds(start, end) / 1000.0;
   }
 
+  inline static Int64 getMonotonicTimeInMicroseconds() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  /*
+   * heap bytes held by a string, its capacity. Short strings live inside the
+   * object. Rows are only moved between being added to an account and
+   * released from it, so they weigh the same both times.
+   */
+  inline static Uint64 getHeapBytes(const std::string& str) {
+    static const std::string::size_type inlineCapacity = std::string().capacity();
+    return str.capacity() > inlineCapacity ? str.capacity() + 1 : 0;
+  }
+
   inline static std::string concat(const char* a, const std::string b) {
     std::string buf(a);
     buf.append(b);
@@ -0,0 +1,52 @@
+/*
+ * This file is part of ePipe
+ * Copyright (C) 2019, Logical Clocks AB. All rights reserved
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef WATERMARKGATE_H
+#define WATERMARKGATE_H
+
+#include "Utils.h"
+
+/*
+ * Counts the items buffered between a pipeline stage and its consumers.
+ * Once the count reaches the high watermark producers block until the
+ * consumers brought it back down to the low watermark, so a slow sink
+ * stalls the stages in front of it instead of growing their queues.
+ */
+class WatermarkGate {
+public:
+  WatermarkGate();
+  void setWatermarks(const Watermarks watermarks);
+  void acquire(const Uint64 count);
+  void release(const Uint64 count);
+  Uint64 getCount();
+  bool isBlocked();
+  Uint64 getBlockedTimeUs();
+
+private:
+  Watermarks mWatermarks;
+  boost::mutex mLock;
+  boost::condition_variable mReleased;
+  Uint64 mCount;
+  bool mBlocked;
+  Uint64 mBlockedTimeUs;
+
+  void add(const Uint64 count);
+};
+
+#endif /* WATERMARKGATE_H */
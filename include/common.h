@@ -101,5 +101,44 @@ struct TableUnitConf {
   }
 };
 
+struct Watermarks {
+  int mHigh;
+  int mLow;
+
+  Watermarks() {
+    mHigh = 0;
+    mLow = 0;
+  }
+
+  Watermarks(int high, int low) {
+    mHigh = high;
+    mLow = low;
+  }
+
+  IVec getVector() {
+    IVec d;
+    d.push_back(mHigh);
+    d.push_back(mLow);
+    return d;
+  }
+
+  void update(std::vector<int> v) {
+    if (v.size() == 2) {
+      mHigh = v[0];
+      mLow = v[1];
+    }
+  }
+
+  std::string getString() {
+    std::stringstream str;
+    str << mHigh << " " << mLow;
+    return str.str();
+  }
+
+  bool isEnabled() const {
+    return mHigh > 0 && mLow >= 0 && mLow < mHigh;
+  }
+};
+
 #endif /* COMMON_H */
 
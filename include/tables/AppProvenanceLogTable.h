@@ -19,6 +19,7 @@
 #include "DBWatchTable.h"
 #include "ConcurrentPriorityQueue.h"
 #include "ConcurrentQueue.h"
+#include "ConcurrentRingBuffer.h"
 
 struct AppProvenancePK {
   std::string mId;
@@ -39,6 +40,8 @@ struct AppProvenancePK {
 };
 
 struct AppProvenanceRow {
+  typedef PKKey<std::string, std::string, Int64> Key;
+
   std::string mId;
   std::string mState;
   Int64 mTimestamp;
@@ -49,6 +52,18 @@ struct AppProvenanceRow {
   Int64 mFinishTime;
 
   ptime mEventCreationTime;
+  // epoch the tailer received the row in
+  Uint64 mEpoch = 0;
+
+  Uint64 getByteSize() const {
+    return sizeof(AppProvenanceRow) + Utils::getHeapBytes(mId)
+        + Utils::getHeapBytes(mState) + Utils::getHeapBytes(mName)
+        + Utils::getHeapBytes(mUser);
+  }
+
+  Key getKey() const {
+    return Key(mId, mState, mTimestamp);
+  }
 
   AppProvenancePK getPK() {
     return AppProvenancePK(mId, mState, mTimestamp);
@@ -105,7 +120,7 @@ struct AppProvenanceRowComparator {
   }
 };
 
-typedef ConcurrentQueue<AppProvenanceRow> AppCPRq;
+typedef ConcurrentRingBuffer<AppProvenanceRow> AppCPRq;
 typedef boost::heap::priority_queue<AppProvenanceRow, boost::heap::compare<AppProvenanceRowComparator> > AppPRpq;
 typedef std::vector <boost::optional<AppProvenancePK> > AppPKeys;
 typedef std::vector <AppProvenanceRow> AppPq;
@@ -143,6 +158,15 @@ public:
   }
 
   AppProvenanceRow getRow(NdbRecAttr* value[]) {
+    return readRow(value);
+  }
+
+  AppProvenanceRow getRow(StagedRecAttr* value[]) {
+    return readRow(value);
+  }
+
+  template<typename RecAttr>
+  AppProvenanceRow readRow(RecAttr* value[]) {
     AppProvenanceRow row;
     row.mEventCreationTime = Utils::getCurrentTime();
     row.mId = get_string(value[0]);
@@ -180,12 +204,18 @@ public:
     }
   }
 
-  std::string getPKStr(AppProvenanceRow row) {
-    return row.getPK().to_string();
+  AppProvenanceRow::Key getKey(const AppProvenanceRow& row) override {
+    return row.getKey();
+  }
+
+  void setEpoch(AppProvenanceRow& row, Uint64 epoch) override {
+    row.mEpoch = epoch;
   }
 
   LogHandler* getLogRemovalHandler(AppProvenanceRow row) override {
-    return new AppProvLogHandler(row.getPK());
+    LogHandler* handler = new AppProvLogHandler(row.getPK());
+    handler->mEpoch = row.mEpoch;
+    return handler;
   }
 
 private:
@@ -22,7 +22,13 @@
 
 #include <boost/any.hpp>
 #include "boost/optional.hpp"
+#include <functional>
+#include <algorithm>
+#include <cstring>
 #include "DBTableBase.h"
+#include "PKKey.h"
+#include "RecAttrArena.h"
+#include "StagedRecAttr.h"
 
 typedef NdbRecAttr** Row;
 typedef std::vector<Row> Rows;
@@ -30,6 +36,11 @@ typedef boost::unordered_map<int, Row> UIRowMap;
 typedef boost::any Any;
 typedef boost::unordered_map<int, Any> AnyMap;
 typedef std::vector<AnyMap> AnyVec;
+typedef std::function<void(NdbRecAttr** values)> RowHandler;
+// the columns of a row read into an NdbRecord row, valid during the call
+typedef std::function<void(StagedRecAttr** values)> RecordRowHandler;
+// epoch and primary key of a scanned row, the key laid out for readKeys
+typedef std::function<void(Uint64 epoch, const char* key)> KeyHandler;
 
 template<typename TableRow>
 class DBTable : public DBTableBase {
@@ -41,13 +52,18 @@ public:
   bool next();
   TableRow currRow();
   Uint64 currEpoch();
+  void setScanBatch(Uint32 batch);
 
   virtual TableRow getRow(NdbRecAttr* values[]) = 0;
+  // same as getRow, for the values staged by the tailer or read into an
+  // NdbRecord row by the primary key reads
+  virtual TableRow getRow(StagedRecAttr* values[]) = 0;
 
   virtual ~DBTable();
 
 private:
   bool mReadEpoch;
+  Uint32 mScanBatch;
   const NdbDictionary::Dictionary* mDatabase;
   const NdbDictionary::Table* mTable;
   const NdbDictionary::Index* mIndex;
@@ -58,14 +74,110 @@ private:
 
   const NdbDictionary::Table* mCompanionTable;
 
+  /*
+   * NdbRecord over the columns of a primary key, an index or a whole row.
+   * The columns are laid out back to back in the buffer, followed by their
+   * null bits. The offsets and columns are indexed by the position of the
+   * value in the PKKey: the position of the column in this table for the
+   * primary key, the position of the column in the index for an index. -1
+   * for the positions not part of the key
+   */
+  struct KeyRecord {
+    const NdbRecord* mRecord = nullptr;
+    std::vector<Int32> mOffsets;
+    std::vector<const NdbDictionary::Column*> mColumns;
+    Uint32 mNoOfColumns = 0;
+    Uint32 mNullBitsOffset = 0;
+    Uint32 mLength = 0;
+  };
+
+  /*
+   * dictionary handles and records of the table resolved once per Ndb
+   * object. An Ndb object is only used by one thread, so the buffers and
+   * the arena below belong to that thread and are reused by every read on
+   * it
+   */
+  struct Handles {
+    NdbDictionary::Dictionary* mDatabase = nullptr;
+    const NdbDictionary::Table* mTable = nullptr;
+    const NdbDictionary::Table* mCompanionTable = nullptr;
+    boost::unordered_map<std::string, const NdbDictionary::Index*> mIndexes;
+    KeyRecord mPrimaryKey;
+    boost::unordered_map<std::string, KeyRecord> mIndexKeys;
+    // every column followed by the row epoch
+    std::vector<NdbOperation::GetValueSpec> mColumnValues;
+    std::vector<NdbOperation::GetValueSpec> mValues;
+    std::vector<unsigned char> mEmptyMask;
+    std::vector<char> mKeys;
+    // every column of the table, the primary key reads fill the projected
+    // ones into mRows and the rows are decoded from there through mRowValues
+    KeyRecord mRowRecord;
+    std::vector<unsigned char> mRowMask;
+    std::vector<char> mRows;
+    std::vector<StagedRecAttr> mRowValues;
+    std::vector<StagedRecAttr*> mRowValuePointers;
+    // NdbRecAttr arrays of the open transaction, reset when it closes
+    RecAttrArena mArena;
+  };
+
+  // the recovery threads add the handles of their connections
+  boost::mutex mHandlesLock;
+  boost::unordered_map<Ndb*, Handles> mHandlesPerConnection;
+  Handles* mHandles;
+
   void close();
+  Handles* getHandles(Ndb* connection);
+  const KeyRecord& getPrimaryKey();
+  const KeyRecord& getRowRecord();
+  const NdbDictionary::Index* getCachedIndex(const std::string& index);
+  const KeyRecord& getIndexKey(const std::string& index);
+  void buildKeyRecord(KeyRecord& key, const NdbDictionary::Index* index,
+      std::vector<const NdbDictionary::Column*> columns);
+  // layout of the keys handed out by scanKeys and the columns they are from
+  KeyRecord mScanKey;
+  Projection mScanKeyColumns;
+
+  Uint32 getNoValues();
+  Uint32 getNoValues(const Projection& projection);
+  NdbOperation::GetValueSpec* prepareValues(Uint32 rows,
+      const Projection& projection);
+  char* prepareKeys(Uint32 rows, Uint32 length);
+  NdbRecAttr** getColumnValues(NdbOperation::GetValueSpec* values,
+      const Projection& projection);
+  char* prepareRows(Uint32 rows, const Projection& projection);
+  StagedRecAttr** getRowValues(const char* row,
+      NdbOperation::GetValueSpec* values, const Projection& projection);
+  template<typename... Columns>
+  const NdbOperation* readTuple(const PKKey<Columns...>& key, char* keyRow,
+      char* row, NdbOperation::GetValueSpec* values);
+  const NdbOperation* readTuple(const char* keyRow, char* row,
+      NdbOperation::GetValueSpec* values);
+  template<typename... Columns, std::size_t... I>
+  void encodeKey(const KeyRecord& record, char* buffer,
+      const PKKey<Columns...>& key, std::index_sequence<I...>);
+  template<typename Column>
+  void encodeColumn(const KeyRecord& record, char* buffer, int index,
+      Column value);
+  void encodeColumn(const KeyRecord& record, char* buffer, int index,
+      const std::string& value);
   void applyConditionOnOperation(NdbOperation* operation, AnyMap& any);
   void applyConditionOnOperationOnCompanion(NdbOperation* operation, AnyMap& any);
+
+  template<typename... Columns, std::size_t... I>
+  void applyKeyOnOperation(NdbOperation* operation,
+      const PKKey<Columns...>& key, std::index_sequence<I...>);
+  template<typename Column>
+  void applyColumnOnOperation(NdbOperation* operation, int index, Column value);
+  void applyColumnOnOperation(NdbOperation* operation, int index,
+      const std::string& value);
   
 protected:
   DBTableBase* mCompanionTableBase;
 
   NdbRecAttr** getColumnValues(NdbOperation* op);
+  NdbRecAttr** getColumnValues(NdbOperation* op, const Projection& projection);
+  void getColumnValues(NdbOperation* op, NdbRecAttr** values,
+      const Projection& projection);
   void start(Ndb* connection);
   void start(Ndb* connection, boost::optional<Int64> partitionId);
   void end();
@@ -78,14 +190,46 @@ protected:
   
   std::vector<TableRow> doRead(Ndb* connection, std::string index, AnyMap& anys);
   std::vector<TableRow> doRead(Ndb* connection, std::string index, AnyMap& anys, boost::optional<Int64> partitionId);
+  void doRead(Ndb* connection, std::string index, AnyMap& anys,
+      boost::optional<Int64> partitionId, const Projection& projection,
+      RowHandler handler);
   bool rowsExists(Ndb* connection, std::string index, AnyMap& anys);
 
   void doDelete(Any any);
   void doDelete(AnyMap& any);
   void doDeleteOnCompanion(AnyMap& any);
 
+  /*
+   * same as the AnyMap variants, but the key columns are given in column
+   * order with their types known at compile time
+   */
+  template<typename... Columns>
+  TableRow doRead(Ndb* connection, const PKKey<Columns...>& key);
+  template<typename... Columns>
+  std::vector<TableRow> doRead(Ndb* connection,
+      const std::vector<PKKey<Columns...> >& keys);
+  template<typename... Columns>
+  void doRead(Ndb* connection, const std::vector<PKKey<Columns...> >& keys,
+      const Projection& projection, RecordRowHandler handler);
+  template<typename... Columns>
+  std::vector<TableRow> doRead(Ndb* connection, std::string index,
+      const PKKey<Columns...>& key,
+      boost::optional<Int64> partitionId = boost::none);
+  template<typename... Columns>
+  void doDelete(const PKKey<Columns...>& key);
+
   void getAll(Ndb* connection, std::string index);
   void setReadEpoch(bool readEpoch);
+  Uint32 getNoPartitions(Ndb* connection);
+  void scanPartition(Ndb* connection, Uint32 partitionId,
+      std::function<void(NdbRecAttr** values)> handler);
+  void scanPartition(Ndb* connection, Uint32 partitionId,
+      const Projection& projection, RowHandler handler);
+  Uint32 prepareKeyScan(Ndb* connection);
+  void scanKeys(Ndb* connection, const std::string& index,
+      boost::optional<Uint32> partitionId, KeyHandler handler);
+  void readKeys(Ndb* connection, const std::vector<const char*>& keys,
+      RecordRowHandler handler);
   
   int getColumnIdInDB(int colIndex);
   int getColumnIdInDB(const char* colName);
@@ -98,13 +242,15 @@ protected:
 
 template<typename TableRow>
 DBTable<TableRow>::DBTable(const std::string table)
-: DBTableBase(table), mReadEpoch(false), mCompanionTableBase(nullptr) {
+: DBTableBase(table), mReadEpoch(false), mScanBatch(0), mHandles(nullptr),
+mCompanionTableBase(nullptr) {
 
 }
 
 template<typename TableRow>
 DBTable<TableRow>::DBTable(const std::string table, DBTableBase* companionTableBase)
-    : DBTableBase(table), mReadEpoch(false), mCompanionTableBase(companionTableBase) {
+    : DBTableBase(table), mReadEpoch(false), mScanBatch(0), mHandles(nullptr),
+    mCompanionTableBase(companionTableBase) {
 }
 
 template<typename TableRow>
@@ -112,18 +258,39 @@ void DBTable<TableRow>::setReadEpoch(bool readEpoch) {
   mReadEpoch = readEpoch;
   LOG_DEBUG(getName() << " -- ReadEpoch : " << mReadEpoch);
 }
+/*
+ * rows per partition returned by every round trip of the full table
+ * scans, 0 lets ndb decide
+ */
+template<typename TableRow>
+void DBTable<TableRow>::setScanBatch(Uint32 batch) {
+  mScanBatch = batch;
+}
+
 template<typename TableRow>
 NdbRecAttr** DBTable<TableRow>::getColumnValues(NdbOperation* op) {
-  int numCols = mReadEpoch ? getNoColumns() + 1 : getNoColumns();
-  NdbRecAttr** values = new NdbRecAttr*[numCols];
-  for (strvec_size_type i = 0; i < getNoColumns(); i++) {
-    values[i] = getNdbOperationValue(op, getColumn(i).c_str());
+  return getColumnValues(op, getAllColumns());
+}
+
+template<typename TableRow>
+NdbRecAttr** DBTable<TableRow>::getColumnValues(NdbOperation* op,
+    const Projection& projection) {
+  NdbRecAttr** values = mHandles->mArena.allocate(getNoValues());
+  getColumnValues(op, values, projection);
+  return values;
+}
+
+template<typename TableRow>
+void DBTable<TableRow>::getColumnValues(NdbOperation* op, NdbRecAttr** values,
+    const Projection& projection) {
+  std::fill(values, values + getNoValues(), nullptr);
+  for (int column : projection) {
+    values[column] = getNdbOperationValue(op, getColumn(column).c_str());
   }
   if (mReadEpoch) {
     values[getNoColumns()] = getNdbOperationValue(op,
         NdbDictionary::Column::ROW_GCI64);
   }
-  return values;
 }
 
 template<typename TableRow>
@@ -131,7 +298,7 @@ void DBTable<TableRow>::getAll(Ndb* connection) {
   start(connection);
   LOG_DEBUG(getName() << " -- GetAll");
   NdbScanOperation* operation = getNdbScanOperation(mCurrentTransaction, mTable);
-  operation->readTuples(NdbOperation::LM_CommittedRead);
+  operation->readTuples(NdbOperation::LM_CommittedRead, 0, 0, mScanBatch);
   mCurrentOperation = operation;
   NdbScanFilter filter(mCurrentOperation);
   applyConditionOnGetAll(filter);
@@ -143,14 +310,149 @@ template<typename TableRow>
 void DBTable<TableRow>::getAll(Ndb* connection, std::string index) {
   start(connection);
   LOG_DEBUG(getName() << " -- GetAll with index : " << index);
-  mIndex = getIndex(mDatabase, index);
+  mIndex = getCachedIndex(index);
   NdbIndexScanOperation* operation = getNdbIndexScanOperation(mCurrentTransaction, mIndex);
-  operation->readTuples(NdbOperation::LM_CommittedRead, NdbScanOperation::SF_OrderBy);
+  operation->readTuples(NdbOperation::LM_CommittedRead, NdbScanOperation::SF_OrderBy, 0, mScanBatch);
   mCurrentOperation = operation;
   mCurrentRow = getColumnValues(mCurrentOperation);
   executeTransaction(mCurrentTransaction, NdbTransaction::Commit);
 }
 
+template<typename TableRow>
+Uint32 DBTable<TableRow>::getNoPartitions(Ndb* connection) {
+  return getTable(getDatabase(connection))->getFragmentCount();
+}
+
+/*
+ * scans a single partition on a transaction of its own and hands every row
+ * to the handler, so several partitions can be scanned at once each on its
+ * own connection
+ */
+template<typename TableRow>
+void DBTable<TableRow>::scanPartition(Ndb* connection, Uint32 partitionId,
+    std::function<void(NdbRecAttr** values)> handler) {
+  scanPartition(connection, partitionId, getAllColumns(), handler);
+}
+
+template<typename TableRow>
+void DBTable<TableRow>::scanPartition(Ndb* connection, Uint32 partitionId,
+    const Projection& projection, RowHandler handler) {
+  const NdbDictionary::Table* table = getTable(getDatabase(connection));
+  NdbTransaction* transaction = startNdbTransaction(connection);
+  NdbScanOperation* operation = getNdbScanOperation(transaction, table);
+  operation->readTuples(NdbOperation::LM_CommittedRead, 0, 1, mScanBatch);
+  operation->setPartitionId(partitionId);
+  NdbScanFilter filter(operation);
+  applyConditionOnGetAll(filter);
+  // several partitions are scanned at once, so the values stay off the arena
+  std::vector<NdbRecAttr*> values(getNoValues());
+  getColumnValues(operation, values.data(), projection);
+  executeTransaction(transaction, NdbTransaction::Commit);
+  while (operation->nextResult(true) == 0) {
+    handler(values.data());
+  }
+  operation->close();
+  transaction->close();
+  LOG_DEBUG(getName() << " -- Scanned partition " << partitionId);
+}
+
+/*
+ * lays the keys of the following scanKeys out for the primary key record,
+ * returns their length
+ */
+template<typename TableRow>
+Uint32 DBTable<TableRow>::prepareKeyScan(Ndb* connection) {
+  mHandles = getHandles(connection);
+  mTable = mHandles->mTable;
+  mScanKey = getPrimaryKey();
+  mScanKeyColumns.clear();
+  for (strvec_size_type c = 0; c < getNoColumns(); c++) {
+    if (mScanKey.mOffsets[c] >= 0) {
+      mScanKeyColumns.push_back(c);
+    }
+  }
+  return mScanKey.mLength;
+}
+
+/*
+ * scans only the primary key and the epoch of the rows, of one partition
+ * or of all of them sorted by the index if given. Several scans can run at
+ * once each on its own connection
+ */
+template<typename TableRow>
+void DBTable<TableRow>::scanKeys(Ndb* connection, const std::string& index,
+    boost::optional<Uint32> partitionId, KeyHandler handler) {
+  const NdbDictionary::Dictionary* database = getDatabase(connection);
+  NdbTransaction* transaction = startNdbTransaction(connection);
+  NdbScanOperation* operation;
+  if (index.empty()) {
+    operation = getNdbScanOperation(transaction, getTable(database));
+    operation->readTuples(NdbOperation::LM_CommittedRead, 0, 1, mScanBatch);
+    if (partitionId) {
+      operation->setPartitionId(partitionId.get());
+    }
+    NdbScanFilter filter(operation);
+    applyConditionOnGetAll(filter);
+  } else {
+    NdbIndexScanOperation* indexOperation = getNdbIndexScanOperation(
+        transaction, getIndex(database, index));
+    indexOperation->readTuples(NdbOperation::LM_CommittedRead,
+        NdbScanOperation::SF_OrderBy, 0, mScanBatch);
+    operation = indexOperation;
+  }
+  std::vector<NdbRecAttr*> values(getNoValues());
+  getColumnValues(operation, values.data(), mScanKeyColumns);
+  executeTransaction(transaction, NdbTransaction::Commit);
+  // none of the key values is null
+  std::vector<char> key(mScanKey.mLength, 0);
+  while (operation->nextResult(true) == 0) {
+    for (int column : mScanKeyColumns) {
+      std::memcpy(key.data() + mScanKey.mOffsets[column],
+          values[column]->aRef(), values[column]->get_size_in_bytes());
+    }
+    handler(values[getNoColumns()]->u_64_value(), key.data());
+  }
+  operation->close();
+  transaction->close();
+}
+
+/*
+ * reads the rows of keys laid out by scanKeys in one round trip and hands
+ * them to the handler in the order of the keys, nullptr for the rows
+ * removed since the scan
+ */
+template<typename TableRow>
+void DBTable<TableRow>::readKeys(Ndb* connection,
+    const std::vector<const char*>& keys, RecordRowHandler handler) {
+  start(connection);
+  LOG_DEBUG(getName() << " -- readKeys : " << keys.size() << " rows");
+  NdbOperation::GetValueSpec* values = prepareValues(keys.size(), Projection());
+  const Uint32 noValues = getNoValues(Projection());
+  char* rows = prepareRows(keys.size(), getAllColumns());
+  const Uint32 rowLength = getRowRecord().mLength;
+  std::vector<const NdbOperation*> operations;
+  operations.reserve(keys.size());
+  for (std::size_t i = 0; i < keys.size(); i++) {
+    operations.push_back(readTuple(keys[i], rows + i * rowLength,
+        values + i * noValues));
+  }
+  if (mCurrentTransaction->execute(NdbTransaction::Commit,
+      NdbOperation::AO_IgnoreError) == -1
+      && mCurrentTransaction->getNdbError().code != 626) {
+    LOG_NDB_API_FATAL(getName(), mCurrentTransaction->getNdbError());
+  }
+
+  for (std::size_t i = 0; i < operations.size(); i++) {
+    const NdbError& error = operations[i]->getNdbError();
+    if (error.code != 0 && error.code != 626) {
+      LOG_NDB_API_FATAL(getName(), error);
+    }
+    handler(error.code == 0 ? getRowValues(rows + i * rowLength,
+        values + i * noValues, getAllColumns()) : nullptr);
+  }
+  close();
+}
+
 template<typename TableRow>
 void DBTable<TableRow>::start(Ndb* connection) {
   start(connection, boost::none);
@@ -158,11 +460,10 @@ void DBTable<TableRow>::start(Ndb* connection) {
 
 template<typename TableRow>
 void DBTable<TableRow>::start(Ndb* connection, boost::optional<Int64> partitionId) {
-  mDatabase = getDatabase(connection);
-  mTable = getTable(mDatabase);
-  if(mCompanionTableBase != nullptr){
-    mCompanionTable = getTable(mDatabase, mCompanionTableBase->getName());
-  }
+  mHandles = getHandles(connection);
+  mDatabase = mHandles->mDatabase;
+  mTable = mHandles->mTable;
+  mCompanionTable = mHandles->mCompanionTable;
   if(partitionId){
     Int64 partId = partitionId.get();
     Ndb::Key_part_ptr distkey[2];
@@ -196,9 +497,369 @@ void DBTable<TableRow>::close() {
   mCurrentTransaction->close();
   mCurrentOperation = NULL;
   mCurrentTransaction = NULL;
+  mCurrentRow = NULL;
+  mHandles->mArena.reset();
   LOG_DEBUG(getName() << " -- Close Transaction");
 }
 
+/*
+ * the dictionary lookups go through a mutex protected cache inside ndb, so
+ * they are done once per Ndb object instead of on every transaction
+ */
+template<typename TableRow>
+typename DBTable<TableRow>::Handles* DBTable<TableRow>::getHandles(Ndb* connection) {
+  boost::mutex::scoped_lock lock(mHandlesLock);
+  typename boost::unordered_map<Ndb*, Handles>::iterator it =
+      mHandlesPerConnection.find(connection);
+  if (it != mHandlesPerConnection.end()) {
+    return &it->second;
+  }
+
+  Handles& handles = mHandlesPerConnection[connection];
+  handles.mDatabase = connection->getDictionary();
+  if (!handles.mDatabase) LOG_NDB_API_FATAL(getName(), connection->getNdbError());
+  handles.mTable = getTable(handles.mDatabase);
+  if (mCompanionTableBase != nullptr) {
+    handles.mCompanionTable = getTable(handles.mDatabase,
+        mCompanionTableBase->getName());
+  }
+  handles.mEmptyMask.assign((handles.mTable->getNoOfColumns() + 7) / 8, 0);
+  LOG_DEBUG(getName() << " -- Cached dictionary handles");
+  return &handles;
+}
+
+template<typename TableRow>
+const NdbDictionary::Index* DBTable<TableRow>::getCachedIndex(const std::string& index) {
+  boost::unordered_map<std::string, const NdbDictionary::Index*>::iterator it
+      = mHandles->mIndexes.find(index);
+  if (it != mHandles->mIndexes.end()) {
+    return it->second;
+  }
+  const NdbDictionary::Index* ndbIndex = getIndex(mHandles->mDatabase, index);
+  mHandles->mIndexes[index] = ndbIndex;
+  return ndbIndex;
+}
+
+template<typename TableRow>
+const typename DBTable<TableRow>::KeyRecord& DBTable<TableRow>::getPrimaryKey() {
+  KeyRecord& key = mHandles->mPrimaryKey;
+  if (key.mRecord == nullptr) {
+    std::vector<const NdbDictionary::Column*> columns;
+    for (int i = 0; i < mTable->getNoOfColumns(); i++) {
+      const NdbDictionary::Column* column = mTable->getColumn(i);
+      if (column->getPrimaryKey()) {
+        columns.push_back(column);
+      }
+    }
+    buildKeyRecord(key, nullptr, columns);
+  }
+  return key;
+}
+
+/*
+ * record over the columns of this table in their order, so the null bit of
+ * a column is at its position
+ */
+template<typename TableRow>
+const typename DBTable<TableRow>::KeyRecord& DBTable<TableRow>::getRowRecord() {
+  KeyRecord& record = mHandles->mRowRecord;
+  if (record.mRecord == nullptr) {
+    std::vector<const NdbDictionary::Column*> columns;
+    for (strvec_size_type i = 0; i < getNoColumns(); i++) {
+      const NdbDictionary::Column* column = mTable->getColumn(getColumn(i).c_str());
+      if (!column) {
+        LOG_FATAL(getName() << " -- column " << getColumn(i) << " does not exist");
+      }
+      columns.push_back(column);
+    }
+    buildKeyRecord(record, nullptr, columns);
+  }
+  return record;
+}
+
+template<typename TableRow>
+const typename DBTable<TableRow>::KeyRecord& DBTable<TableRow>::getIndexKey(
+    const std::string& index) {
+  typename boost::unordered_map<std::string, KeyRecord>::iterator it =
+      mHandles->mIndexKeys.find(index);
+  if (it != mHandles->mIndexKeys.end()) {
+    return it->second;
+  }
+  const NdbDictionary::Index* ndbIndex = getCachedIndex(index);
+  std::vector<const NdbDictionary::Column*> columns;
+  for (unsigned i = 0; i < ndbIndex->getNoOfColumns(); i++) {
+    columns.push_back(mTable->getColumn(ndbIndex->getColumn(i)->getName()));
+  }
+  KeyRecord& key = mHandles->mIndexKeys[index];
+  buildKeyRecord(key, ndbIndex, columns);
+  return key;
+}
+
+template<typename TableRow>
+void DBTable<TableRow>::buildKeyRecord(KeyRecord& key,
+    const NdbDictionary::Index* index,
+    std::vector<const NdbDictionary::Column*> columns) {
+  std::vector<NdbDictionary::RecordSpecification> specs(columns.size());
+  std::vector<Uint32> offsets(columns.size());
+  Uint32 offset = 0;
+  for (std::size_t i = 0; i < columns.size(); i++) {
+    offsets[i] = offset;
+    offset += (columns[i]->getSizeInBytes() + 7) & ~7;
+  }
+  key.mNullBitsOffset = offset;
+  key.mLength = offset + (columns.size() + 7) / 8;
+
+  for (std::size_t i = 0; i < columns.size(); i++) {
+    specs[i].column = columns[i];
+    specs[i].offset = offsets[i];
+    specs[i].nullbit_byte_offset = key.mNullBitsOffset + i / 8;
+    specs[i].nullbit_bit_in_byte = i % 8;
+    specs[i].column_flags = 0;
+  }
+
+  if (index == nullptr) {
+    // the primary key values come in the order of the columns of this table
+    key.mOffsets.assign(getNoColumns(), -1);
+    key.mColumns.assign(getNoColumns(), nullptr);
+    for (std::size_t i = 0; i < columns.size(); i++) {
+      for (strvec_size_type c = 0; c < getNoColumns(); c++) {
+        if (getColumn(c) == columns[i]->getName()) {
+          key.mOffsets[c] = offsets[i];
+          key.mColumns[c] = columns[i];
+        }
+      }
+    }
+  } else {
+    key.mOffsets.assign(offsets.begin(), offsets.end());
+    key.mColumns = columns;
+  }
+
+  key.mRecord = createNdbRecord(mHandles->mDatabase, index, mTable,
+      specs.data(), specs.size());
+  key.mNoOfColumns = columns.size();
+  LOG_DEBUG(getName() << " -- Created key record of " << key.mNoOfColumns
+      << " columns for " << (index == nullptr ? "the primary key" : index->getName()));
+}
+
+/*
+ * the rows hand out a value per column followed by the epoch, whether the
+ * column was read or not
+ */
+template<typename TableRow>
+Uint32 DBTable<TableRow>::getNoValues() {
+  return mReadEpoch ? getNoColumns() + 1 : getNoColumns();
+}
+
+template<typename TableRow>
+Uint32 DBTable<TableRow>::getNoValues(const Projection& projection) {
+  return mReadEpoch ? projection.size() + 1 : projection.size();
+}
+
+/*
+ * getValue specs of the projected columns for the given number of
+ * operations, ndb hands back the NdbRecAttr of every column inside them
+ */
+template<typename TableRow>
+NdbOperation::GetValueSpec* DBTable<TableRow>::prepareValues(Uint32 rows,
+    const Projection& projection) {
+  std::vector<NdbOperation::GetValueSpec>& columnValues = mHandles->mColumnValues;
+  if (columnValues.empty()) {
+    columnValues.resize(getNoColumns() + 1);
+    for (strvec_size_type i = 0; i < getNoColumns(); i++) {
+      columnValues[i].column = mTable->getColumn(getColumn(i).c_str());
+      if (!columnValues[i].column) {
+        LOG_FATAL(getName() << " -- column " << getColumn(i) << " does not exist");
+      }
+      columnValues[i].appStorage = nullptr;
+      columnValues[i].recAttr = nullptr;
+    }
+    columnValues[getNoColumns()].column = NdbDictionary::Column::ROW_GCI64;
+    columnValues[getNoColumns()].appStorage = nullptr;
+    columnValues[getNoColumns()].recAttr = nullptr;
+  }
+
+  Uint32 noValues = getNoValues(projection);
+  std::vector<NdbOperation::GetValueSpec>& values = mHandles->mValues;
+  if (values.size() < rows * noValues) {
+    values.resize(rows * noValues);
+  }
+  for (Uint32 i = 0; i < rows; i++) {
+    NdbOperation::GetValueSpec* row = values.data() + i * noValues;
+    for (std::size_t c = 0; c < projection.size(); c++) {
+      row[c] = columnValues[projection[c]];
+    }
+    if (mReadEpoch) {
+      row[projection.size()] = columnValues[getNoColumns()];
+    }
+  }
+  return values.data();
+}
+
+template<typename TableRow>
+char* DBTable<TableRow>::prepareKeys(Uint32 rows, Uint32 length) {
+  if (mHandles->mKeys.size() < rows * length) {
+    mHandles->mKeys.resize(rows * length);
+  }
+  return mHandles->mKeys.data();
+}
+
+template<typename TableRow>
+NdbRecAttr** DBTable<TableRow>::getColumnValues(
+    NdbOperation::GetValueSpec* values, const Projection& projection) {
+  NdbRecAttr** recAttrs = mHandles->mArena.allocate(getNoValues());
+  std::fill(recAttrs, recAttrs + getNoValues(), nullptr);
+  for (std::size_t c = 0; c < projection.size(); c++) {
+    recAttrs[projection[c]] = values[c].recAttr;
+  }
+  if (mReadEpoch) {
+    recAttrs[getNoColumns()] = values[projection.size()].recAttr;
+  }
+  return recAttrs;
+}
+
+/*
+ * rows for the given number of primary key reads and the mask of the
+ * projected columns they are filled with
+ */
+template<typename TableRow>
+char* DBTable<TableRow>::prepareRows(Uint32 rows, const Projection& projection) {
+  const KeyRecord& record = getRowRecord();
+  if (mHandles->mRows.size() < rows * record.mLength) {
+    mHandles->mRows.resize(rows * record.mLength);
+  }
+  std::vector<unsigned char>& mask = mHandles->mRowMask;
+  mask.assign(mHandles->mEmptyMask.size(), 0);
+  for (int c : projection) {
+    int attrId = record.mColumns[c]->getColumnNo();
+    mask[attrId >> 3] |= 1 << (attrId & 7);
+  }
+  return mHandles->mRows.data();
+}
+
+/*
+ * the projected columns of a row filled by readTuple followed by the epoch,
+ * the others are null. Valid until the next call
+ */
+template<typename TableRow>
+StagedRecAttr** DBTable<TableRow>::getRowValues(const char* row,
+    NdbOperation::GetValueSpec* values, const Projection& projection) {
+  const KeyRecord& record = getRowRecord();
+  std::vector<StagedRecAttr>& staged = mHandles->mRowValues;
+  std::vector<StagedRecAttr*>& pointers = mHandles->mRowValuePointers;
+  if (staged.empty()) {
+    staged.resize(getNoColumns() + 1);
+    pointers.resize(getNoColumns() + 1);
+  }
+  std::fill(pointers.begin(), pointers.end(), nullptr);
+  for (int c : projection) {
+    const NdbDictionary::Column* column = record.mColumns[c];
+    bool isNull = column->getNullable()
+        && (row[record.mNullBitsOffset + c / 8] >> (c % 8)) & 1;
+    staged[c].refer(column, row + record.mOffsets[c], isNull);
+    pointers[c] = &staged[c];
+  }
+  if (mReadEpoch) {
+    staged[getNoColumns()].refer(values[0].recAttr);
+    pointers[getNoColumns()] = &staged[getNoColumns()];
+  }
+  return pointers.data();
+}
+
+/*
+ * defines a primary key read on the key record of the table, the key is
+ * encoded into keyRow which has to stay untouched until the execute
+ */
+template<typename TableRow>
+template<typename... Columns>
+const NdbOperation* DBTable<TableRow>::readTuple(const PKKey<Columns...>& key,
+    char* keyRow, char* row, NdbOperation::GetValueSpec* values) {
+  const KeyRecord& record = getPrimaryKey();
+  if (sizeof...(Columns) != record.mNoOfColumns) {
+    LOG_FATAL(getName() << " -- primary key has " << record.mNoOfColumns
+        << " columns, got " << sizeof...(Columns));
+  }
+  encodeKey(record, keyRow, key, std::index_sequence_for<Columns...>());
+  return readTuple(keyRow, row, values);
+}
+
+/*
+ * same, for a key already laid out for the primary key record. The columns
+ * of the mask set by prepareRows are read into row, the epoch into values
+ */
+template<typename TableRow>
+const NdbOperation* DBTable<TableRow>::readTuple(const char* keyRow,
+    char* row, NdbOperation::GetValueSpec* values) {
+  NdbOperation::OperationOptions options;
+  options.optionsPresent = mReadEpoch
+      ? NdbOperation::OperationOptions::OO_GETVALUE : 0;
+  options.extraGetValues = values;
+  options.numExtraGetValues = mReadEpoch ? 1 : 0;
+  const NdbOperation* op = mCurrentTransaction->readTuple(
+      getPrimaryKey().mRecord, keyRow, getRowRecord().mRecord, row,
+      NdbOperation::LM_CommittedRead, mHandles->mRowMask.data(), &options,
+      sizeof(options));
+  if (!op) LOG_NDB_API_FATAL(getName(), mCurrentTransaction->getNdbError());
+  return op;
+}
+
+template<typename TableRow>
+template<typename... Columns, std::size_t... I>
+void DBTable<TableRow>::encodeKey(const KeyRecord& record, char* buffer,
+    const PKKey<Columns...>& key, std::index_sequence<I...>) {
+  if (sizeof...(Columns) > record.mOffsets.size()) {
+    LOG_FATAL(getName() << " -- key of " << sizeof...(Columns)
+        << " columns, the record has " << record.mOffsets.size());
+  }
+  // none of the key values is null
+  std::memset(buffer + record.mNullBitsOffset, 0,
+      record.mLength - record.mNullBitsOffset);
+  int expand[] = {0, (encodeColumn(record, buffer, I, key.template get<I>()), 0)...};
+  (void) expand;
+}
+
+template<typename TableRow>
+template<typename Column>
+void DBTable<TableRow>::encodeColumn(const KeyRecord& record, char* buffer,
+    int index, Column value) {
+  static_assert(std::is_integral<Column>::value,
+      "key columns are either integral or strings");
+  if (record.mOffsets[index] < 0) {
+    LOG_FATAL(getName() << " -- key value " << index << " is not a key column");
+  }
+  const NdbDictionary::Column* column = record.mColumns[index];
+  if (column->getSizeInBytes() != static_cast<int>(sizeof(value))) {
+    LOG_FATAL(getName() << " -- key column " << column->getName() << " has "
+        << column->getSizeInBytes() << " bytes, got a value of "
+        << sizeof(value));
+  }
+  std::memcpy(buffer + record.mOffsets[index], &value, sizeof(value));
+}
+
+template<typename TableRow>
+void DBTable<TableRow>::encodeColumn(const KeyRecord& record, char* buffer,
+    int index, const std::string& value) {
+  if (record.mOffsets[index] < 0) {
+    LOG_FATAL(getName() << " -- key value " << index << " is not a key column");
+  }
+  const NdbDictionary::Column* column = record.mColumns[index];
+  switch (column->getType()) {
+    case NdbDictionary::Column::Char:
+    case NdbDictionary::Column::Varchar:
+    case NdbDictionary::Column::Longvarchar:
+    case NdbDictionary::Column::Binary:
+    case NdbDictionary::Column::Varbinary:
+    case NdbDictionary::Column::Longvarbinary:
+      break;
+    default:
+      LOG_FATAL(getName() << " -- key column " << column->getName()
+          << " is not a string column");
+  }
+  if (write_ndb_varchar(value, column, buffer + record.mOffsets[index]) < 0) {
+    LOG_FATAL(getName() << " -- key of " << value.length()
+        << " bytes does not fit " << column->getName());
+  }
+}
+
 template<typename TableRow>
 bool DBTable<TableRow>::next() {
   if (mCurrentOperation != NULL) {
@@ -261,22 +922,36 @@ std::vector<TableRow> DBTable<TableRow>::doRead(Ndb* connection, std::string ind
 
 template<typename TableRow>
 std::vector<TableRow> DBTable<TableRow>::doRead(Ndb* connection, std::string index, AnyMap& any, boost::optional<Int64> partitionId){
+  std::vector<TableRow> results;
+  doRead(connection, index, any, partitionId, getAllColumns(),
+      [this, &results](NdbRecAttr** values) {
+        results.push_back(getRow(values));
+      });
+  return results;
+}
+
+/*
+ * hands the projected columns of every matching row to the handler, for
+ * the callers needing only a few of the columns of the table
+ */
+template<typename TableRow>
+void DBTable<TableRow>::doRead(Ndb* connection, std::string index,
+    AnyMap& any, boost::optional<Int64> partitionId,
+    const Projection& projection, RowHandler handler){
   start(connection, partitionId);
-  LOG_DEBUG(getName() << " -- doRead with index : " << index);
-  mIndex = getIndex(mDatabase, index);
+  LOG_DEBUG(getName() << " -- doRead with index : " << index << " of "
+      << projection.size() << " columns");
+  mIndex = getCachedIndex(index);
   NdbIndexScanOperation* operation = getNdbIndexScanOperation(mCurrentTransaction, mIndex);
   operation->readTuples(NdbOperation::LM_CommittedRead);
   mCurrentOperation = operation;
   applyConditionOnOperation(operation, any);
-  mCurrentRow = getColumnValues(mCurrentOperation);
+  mCurrentRow = getColumnValues(mCurrentOperation, projection);
   executeTransaction(mCurrentTransaction, NdbTransaction::Commit);
-  std::vector<TableRow> results;
   while (operation->nextResult(true) == 0){
-    TableRow row = getRow(mCurrentRow);
-    results.push_back(row);
+    handler(mCurrentRow);
   }
   close();
-  return results;
 }
 
 template<typename TableRow>
@@ -284,12 +959,13 @@ bool DBTable<TableRow>::rowsExists(Ndb* connection, std::string index,
     AnyMap& any){
   start(connection);
   LOG_DEBUG(getName() << " -- hasResults with index : " << index);
-  mIndex = getIndex(mDatabase, index);
+  mIndex = getCachedIndex(index);
   NdbIndexScanOperation* operation = getNdbIndexScanOperation(mCurrentTransaction, mIndex);
   operation->readTuples(NdbOperation::LM_CommittedRead);
   mCurrentOperation = operation;
   applyConditionOnOperation(operation, any);
-  mCurrentRow = getColumnValues(mCurrentOperation);
+  // only whether a row comes back matters, no column is read
+  mCurrentRow = getColumnValues(mCurrentOperation, Projection());
   executeTransaction(mCurrentTransaction, NdbTransaction::Commit);
   bool hasMoreRows = operation->nextResult(true) == 0;
   close();
@@ -320,12 +996,132 @@ void DBTable<TableRow>::doDeleteOnCompanion(AnyMap& any) {
 }
 
 
+template<typename TableRow>
+template<typename... Columns>
+TableRow DBTable<TableRow>::doRead(Ndb* connection,
+    const PKKey<Columns...>& key) {
+  start(connection);
+  LOG_DEBUG(getName() << " -- doRead " << key.to_string());
+  char* keyRow = prepareKeys(1, getPrimaryKey().mLength);
+  char* row = prepareRows(1, getAllColumns());
+  NdbOperation::GetValueSpec* values = prepareValues(1, Projection());
+  readTuple(key, keyRow, row, values);
+  executeTransaction(mCurrentTransaction, NdbTransaction::Commit);
+  TableRow result = getRow(getRowValues(row, values, getAllColumns()));
+  close();
+  return result;
+}
+
+template<typename TableRow>
+template<typename... Columns>
+std::vector<TableRow> DBTable<TableRow>::doRead(Ndb* connection,
+    const std::vector<PKKey<Columns...> >& keys) {
+  std::vector<TableRow> results;
+  results.reserve(keys.size());
+  doRead(connection, keys, getAllColumns(),
+      [this, &results](StagedRecAttr** values) {
+        results.push_back(getRow(values));
+      });
+  return results;
+}
+
+/*
+ * hands the projected columns of every row to the handler, in the order of
+ * the keys. The rows are read into NdbRecord rows and decoded from there
+ */
+template<typename TableRow>
+template<typename... Columns>
+void DBTable<TableRow>::doRead(Ndb* connection,
+    const std::vector<PKKey<Columns...> >& keys, const Projection& projection,
+    RecordRowHandler handler) {
+  start(connection);
+  LOG_DEBUG(getName() << " -- doRead : " << keys.size() << " rows of "
+      << projection.size() << " columns");
+  const Uint32 keyLength = getPrimaryKey().mLength;
+  char* keyRows = prepareKeys(keys.size(), keyLength);
+  char* rows = prepareRows(keys.size(), projection);
+  const Uint32 rowLength = getRowRecord().mLength;
+  NdbOperation::GetValueSpec* values = prepareValues(keys.size(), Projection());
+  const Uint32 noValues = getNoValues(Projection());
+  for (std::size_t i = 0; i < keys.size(); i++) {
+    readTuple(keys[i], keyRows + i * keyLength, rows + i * rowLength,
+        values + i * noValues);
+  }
+  executeTransaction(mCurrentTransaction, NdbTransaction::Commit);
+
+  for (std::size_t i = 0; i < keys.size(); i++) {
+    handler(getRowValues(rows + i * rowLength, values + i * noValues,
+        projection));
+  }
+  close();
+}
+
+/*
+ * scans the index for the rows matching the key, the key columns have to
+ * be a prefix of the index columns
+ */
+template<typename TableRow>
+template<typename... Columns>
+std::vector<TableRow> DBTable<TableRow>::doRead(Ndb* connection,
+    std::string index, const PKKey<Columns...>& key,
+    boost::optional<Int64> partitionId) {
+  start(connection, partitionId);
+  LOG_DEBUG(getName() << " -- doRead with index : " << index);
+  const KeyRecord& record = getIndexKey(index);
+  char* keyRow = prepareKeys(1, record.mLength);
+  encodeKey(record, keyRow, key, std::index_sequence_for<Columns...>());
+
+  NdbIndexScanOperation::IndexBound bound;
+  bound.low_key = keyRow;
+  bound.low_key_count = sizeof...(Columns);
+  bound.low_inclusive = true;
+  bound.high_key = keyRow;
+  bound.high_key_count = sizeof...(Columns);
+  bound.high_inclusive = true;
+  bound.range_no = 0;
+
+  NdbOperation::GetValueSpec* values = prepareValues(1, getAllColumns());
+  NdbScanOperation::ScanOptions options;
+  options.optionsPresent = NdbScanOperation::ScanOptions::SO_GETVALUE;
+  options.extraGetValues = values;
+  options.numExtraGetValues = getNoValues(getAllColumns());
+
+  NdbIndexScanOperation* operation = mCurrentTransaction->scanIndex(
+      record.mRecord, mTable->getDefaultRecord(),
+      NdbOperation::LM_CommittedRead, mHandles->mEmptyMask.data(), &bound,
+      &options, sizeof(options));
+  if (!operation) LOG_NDB_API_FATAL(getName(), mCurrentTransaction->getNdbError());
+  mCurrentOperation = operation;
+  mCurrentRow = getColumnValues(values, getAllColumns());
+  executeTransaction(mCurrentTransaction, NdbTransaction::Commit);
+  std::vector<TableRow> results;
+  const char* row;
+  while (operation->nextResult(&row, true, false) == 0){
+    results.push_back(getRow(mCurrentRow));
+  }
+  close();
+  return results;
+}
+
+template<typename TableRow>
+template<typename... Columns>
+void DBTable<TableRow>::doDelete(const PKKey<Columns...>& key) {
+  LOG_DEBUG(getName() << " -- doDelete " << key.to_string());
+  mCurrentOperation = getNdbOperation(mCurrentTransaction, mTable);
+  mCurrentOperation->deleteTuple();
+  applyKeyOnOperation(mCurrentOperation, key,
+      std::index_sequence_for<Columns...>());
+}
+
 template<typename TableRow>
 boost::unordered_map<int, TableRow> DBTable<TableRow>::doRead(Ndb* connection, UISet& ids){
-  AnyVec anyVec;
+  std::vector<PKKey<int> > keys;
   IVec idsVec;
-  convert(ids, anyVec, idsVec);
-  std::vector<TableRow> rows = doRead(connection, anyVec);
+  for (int id : ids) {
+    keys.push_back(PKKey<int>(id));
+    idsVec.push_back(id);
+  }
+  std::vector<TableRow> rows = doRead(connection, keys);
   boost::unordered_map<int, TableRow> results;
   int i=0;
   for(typename std::vector<TableRow>::iterator it = rows.begin(); it!=rows.end(); ++it, i++){
@@ -336,10 +1132,13 @@ boost::unordered_map<int, TableRow> DBTable<TableRow>::doRead(Ndb* connection, U
 
 template<typename TableRow>
 boost::unordered_map<Int64, TableRow> DBTable<TableRow>::doRead(Ndb* connection, ULSet& ids){
-  AnyVec anyVec;
+  std::vector<PKKey<Int64> > keys;
   LVec idsVec;
-  convert(ids, anyVec, idsVec);
-  std::vector<TableRow> rows = doRead(connection, anyVec);
+  for (Int64 id : ids) {
+    keys.push_back(PKKey<Int64>(id));
+    idsVec.push_back(id);
+  }
+  std::vector<TableRow> rows = doRead(connection, keys);
   boost::unordered_map<Int64, TableRow> results;
   int i=0;
   for(typename std::vector<TableRow>::iterator it = rows.begin(); it!=rows.end(); ++it, i++){
@@ -417,8 +1216,7 @@ void DBTable<TableRow>::applyConditionOnOperation(NdbOperation* operation, AnyMa
     } else if (a.type() == typeid (std::string)) {
       std::string pk = boost::any_cast<std::string>(a);
       log << colName << " = " << pk << std::endl;
-      operation->equal(colName.c_str(), get_ndb_varchar(pk,
-              mTable->getColumn(colName.c_str())->getArrayType()).c_str());
+      equalNdbVarchar(operation, mTable, colName, pk);
     }else{
       LOG_ERROR(getName() << " -- apply where unknown type" << a.type().name());
     }
@@ -453,8 +1251,7 @@ void DBTable<TableRow>::applyConditionOnOperationOnCompanion(NdbOperation* opera
     } else if (a.type() == typeid (std::string)) {
       std::string pk = boost::any_cast<std::string>(a);
       log << colName << " = " << pk << std::endl;
-      operation->equal(colName.c_str(), get_ndb_varchar(pk,
-          mCompanionTable->getColumn(colName.c_str())->getArrayType()).c_str());
+      equalNdbVarchar(operation, mCompanionTable, colName, pk);
     }else{
       LOG_ERROR(getName() << " : " << mCompanionTableBase->getName() << " -- apply where unknown type" << a.type().name());
     }
@@ -462,6 +1259,33 @@ void DBTable<TableRow>::applyConditionOnOperationOnCompanion(NdbOperation* opera
   LOG_DEBUG(getName()  << " : " << mCompanionTableBase->getName() << " -- apply conditions on operation " << std::endl << log.str());
 }
 
+/*
+ * the column of every key part follows from its position, the overload of
+ * equal from its type
+ */
+template<typename TableRow>
+template<typename... Columns, std::size_t... I>
+void DBTable<TableRow>::applyKeyOnOperation(NdbOperation* operation,
+    const PKKey<Columns...>& key, std::index_sequence<I...>) {
+  int expand[] = {0, (applyColumnOnOperation(operation, I, key.template get<I>()), 0)...};
+  (void) expand;
+}
+
+template<typename TableRow>
+template<typename Column>
+void DBTable<TableRow>::applyColumnOnOperation(NdbOperation* operation,
+    int index, Column value) {
+  static_assert(std::is_integral<Column>::value, "unsupported key column type");
+  operation->equal(getColumn(index).c_str(), value);
+}
+
+template<typename TableRow>
+void DBTable<TableRow>::applyColumnOnOperation(NdbOperation* operation,
+    int index, const std::string& value) {
+  const std::string& colName = getColumn(index);
+  equalNdbVarchar(operation, mTable, colName, value);
+}
+
 template<typename TableRow>
 void DBTable<TableRow>::convert(UISet& ids, AnyVec& resultAny, IVec& resultVec){
   for(UISet::iterator it=ids.begin(); it != ids.end(); ++it){
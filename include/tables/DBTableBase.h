@@ -20,6 +20,10 @@
 #ifndef DBTABLEBASE_H
 #define DBTABLEBASE_H
 #include "Utils.h"
+#include <boost/utility/string_view.hpp>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 inline static int DONT_EXIST_INT() {
   return -1;
@@ -30,6 +34,8 @@ inline const static std::string DONT_EXIST_STR() {
 }
 
 typedef typename std::vector<std::string>::size_type strvec_size_type;
+// positions of the columns to read, the values of the others are left null
+typedef std::vector<int> Projection;
 
 struct NdbTupleDidNotExist : public std::exception {
   const char * what () const throw () {
@@ -59,13 +65,14 @@ public:
     return mColumns.size();
   }
 
- const char** getColumns() {
-    const char** columns = new const char*[getNoColumns()];
-    for (strvec_size_type i = 0; i < getNoColumns(); i++) {
-      std::string colStr = getColumn(i);
-      char* col = new char[colStr.size()];
-      strcpy(col, colStr.c_str());
-      columns[i] = col;
+  /*
+   * the names point into the columns of the table, valid as long as it is
+   */
+  std::vector<const char*> getColumns() const {
+    std::vector<const char*> columns;
+    columns.reserve(getNoColumns());
+    for (const std::string& column : mColumns) {
+      columns.push_back(column.c_str());
     }
     return columns;
   }
@@ -73,6 +80,8 @@ public:
 private:
   const std::string mTableName;
   StrVec mColumns;
+  // filled along with the columns, so concurrent readers never change it
+  Projection mAllColumns;
 
 protected:
 
@@ -80,9 +89,14 @@ protected:
    * Make sure to add the primary key columns first
    */
   void addColumn(std::string column) {
+    mAllColumns.push_back(mColumns.size());
     mColumns.push_back(column);
   }
 
+  const Projection& getAllColumns() const {
+    return mAllColumns;
+  }
+
   const NdbDictionary::Dictionary* getDatabase(Ndb* connection) {
     const NdbDictionary::Dictionary* database = connection->getDictionary();
     if (!database) LOG_NDB_API_FATAL(getName(), connection->getNdbError());
@@ -137,12 +151,40 @@ protected:
     return col;
   }
 
+  /*
+   * ndb copies the key when it is applied, so it is encoded on the stack
+   */
+  void equalNdbVarchar(NdbOperation* op, const NdbDictionary::Table* table,
+      const std::string& column_name, const std::string& value) {
+    char key[NDB_MAX_KEYSIZE_IN_WORDS * 4];
+    const NdbDictionary::Column* column = table->getColumn(column_name.c_str());
+    if (column->getSizeInBytes() > static_cast<int>(sizeof(key))) {
+      LOG_FATAL(getName() << " -- key column " << column_name << " of "
+          << column->getSizeInBytes() << " bytes");
+    }
+    if (write_ndb_varchar(value, column, key) < 0) {
+      LOG_FATAL(getName() << " -- key of " << value.length()
+          << " bytes does not fit " << column_name);
+    }
+    op->equal(column_name.c_str(), key);
+  }
+
   NdbIndexScanOperation* getNdbIndexScanOperation(NdbTransaction* transaction, const NdbDictionary::Index* index) {
     NdbIndexScanOperation* op = transaction->getNdbIndexScanOperation(index);
     if (!op) LOG_NDB_API_FATAL(getName(), transaction->getNdbError());
     return op;
   }
 
+  NdbRecord* createNdbRecord(NdbDictionary::Dictionary* database,
+      const NdbDictionary::Index* index, const NdbDictionary::Table* table,
+      const NdbDictionary::RecordSpecification* specs, Uint32 length) {
+    NdbRecord* record = index == nullptr
+        ? database->createRecord(table, specs, length, sizeof(specs[0]))
+        : database->createRecord(index, specs, length, sizeof(specs[0]));
+    if (!record) LOG_NDB_API_FATAL(getName(), database->getNdbError());
+    return record;
+  }
+
   NdbTransaction* startNdbTransaction(Ndb* connection) {
     NdbTransaction* ts = connection->startTransaction();
     if (!ts) LOG_NDB_API_FATAL(getName(), connection->getNdbError());
@@ -167,36 +209,53 @@ protected:
     }
   }
 
-  std::string get_ndb_varchar(std::string str, NdbDictionary::Column::ArrayType array_type) {
-    std::stringstream data;
-    int len = str.length();
-
-    switch (array_type) {
+  /*
+   * writes str into buffer the way ndb stores it in the given column, length
+   * bytes first, and fills the rest of the column, with blanks for fixed
+   * chars and zeros otherwise. Returns the bytes of the column, -1 when str
+   * does not fit in it
+   */
+  int write_ndb_varchar(const std::string& str,
+      const NdbDictionary::Column* column, char* buffer) {
+    std::size_t prefix = 0;
+    switch (column->getArrayType()) {
       case NdbDictionary::Column::ArrayTypeFixed:
         /*
          No prefix length is stored in aRef. Data starts from aRef's first byte
          data might be padded with blank or null bytes to fill the whole column
          */
-        data << str;
         break;
       case NdbDictionary::Column::ArrayTypeShortVar:
         /*
          First byte of aRef has the length of data stored
          Data starts from second byte of aRef
          */
-        data << ((char) len) << str;
+        prefix = 1;
         break;
       case NdbDictionary::Column::ArrayTypeMediumVar:
         /*
          First two bytes of aRef has the length of data stored
          Data starts from third byte of aRef
          */
-        int m = len / 256;
-        int l = len % 256;
-        data << ((char) l) << ((char) m) << str;
+        prefix = 2;
         break;
     }
-    return data.str();
+    const std::size_t size = column->getSizeInBytes();
+    const std::size_t len = str.length();
+    if (size < prefix || len > size - prefix) {
+      return -1;
+    }
+    if (prefix == 1) {
+      buffer[0] = (char) len;
+    } else if (prefix == 2) {
+      buffer[0] = (char) (len % 256);
+      buffer[1] = (char) (len / 256);
+    }
+    std::memcpy(buffer + prefix, str.data(), len);
+    const char fill = column->getType() == NdbDictionary::Column::Char
+        ? ' ' : 0;
+    std::memset(buffer + prefix + len, fill, size - prefix - len);
+    return size;
   }
 
   /*
@@ -205,7 +264,8 @@ protected:
    */
 
   /* extracts the length and the start byte of the data stored */
-  int get_byte_array(const NdbRecAttr* attr,
+  template<typename RecAttr>
+  int get_byte_array(const RecAttr* attr,
           const char*& first_byte,
           size_t& bytes) {
     const NdbDictionary::Column::ArrayType array_type =
@@ -245,42 +305,80 @@ protected:
     }
   }
 
-  std::string latin1_to_utf8(std::string &str) {
-    std::string strOut;
-    for (std::string::iterator it = str.begin(); it != str.end(); ++it) {
-      uint8_t ch = *it;
-      if (ch < 0x80) {
-        strOut.push_back(ch);
-      } else {
-        strOut.push_back(0xc0 | ch >> 6);
-        strOut.push_back(0x80 | (ch & 0x3f));
+  /* number of bytes before the first non ascii one */
+  static std::size_t ascii_prefix(const char* data, std::size_t len) {
+    std::size_t i = 0;
+#ifdef __SSE2__
+    for (; i + 16 <= len; i += 16) {
+      __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+      int mask = _mm_movemask_epi8(chunk);
+      if (mask != 0) {
+        return i + __builtin_ctz(mask);
       }
     }
+#endif
+    while (i < len && static_cast<uint8_t>(data[i]) < 0x80) {
+      i++;
+    }
+    return i;
+  }
+
+  /*
+   * the ascii runs are copied as they are, only the bytes above 0x7f take
+   * two bytes in utf8
+   */
+  std::string latin1_to_utf8(boost::string_view str) {
+    const char* data = str.data();
+    std::size_t len = str.size();
+    std::size_t i = ascii_prefix(data, len);
+    if (i == len) {
+      return std::string(data, len);
+    }
+
+    std::string strOut;
+    strOut.reserve(len + (len - i));
+    strOut.append(data, i);
+    while (i < len) {
+      uint8_t ch = data[i++];
+      strOut.push_back(0xc0 | ch >> 6);
+      strOut.push_back(0x80 | (ch & 0x3f));
+      std::size_t run = ascii_prefix(data + i, len - i);
+      strOut.append(data + i, run);
+      i += run;
+    }
     return strOut;
   }
 
   /*
-   Extracts the string from given NdbRecAttr
-   Uses get_byte_array internally
+   Points at the latin1 string stored in the given NdbRecAttr or
+   StagedRecAttr, without the blank padding of fixed chars. Valid as long
+   as the attribute is
    */
-  std::string get_string(const NdbRecAttr* attr) {
+  template<typename RecAttr>
+  boost::string_view get_string_view(const RecAttr* attr) {
     size_t attr_bytes;
     const char* data_start_ptr = NULL;
 
     /* get stored length and data using get_byte_array */
-    if (get_byte_array(attr, data_start_ptr, attr_bytes) == 0) {
-      /* we have length of the string and start location */
-      std::string str = std::string(data_start_ptr, attr_bytes);
-      if (attr->getType() == NdbDictionary::Column::Char) {
-        /* Fixed Char : remove blank spaces at the end */
-        size_t endpos = str.find_last_not_of(" ");
-        if (std::string::npos != endpos) {
-          str = str.substr(0, endpos + 1);
-        }
-      }
-      return latin1_to_utf8(str);
+    if (get_byte_array(attr, data_start_ptr, attr_bytes) != 0) {
+      return boost::string_view();
     }
-    return NULL;
+    boost::string_view str(data_start_ptr, attr_bytes);
+    if (attr->getType() == NdbDictionary::Column::Char) {
+      /* Fixed Char : remove blank spaces at the end */
+      size_t endpos = str.find_last_not_of(' ');
+      str = str.substr(0, boost::string_view::npos != endpos ? endpos + 1 : 0);
+    }
+    return str;
+  }
+
+  /*
+   Extracts the string from given NdbRecAttr
+   Uses get_string_view internally
+   */
+  template<typename RecAttr>
+  std::string get_string(const RecAttr* attr) {
+    return latin1_to_utf8(get_string_view(attr));
   }
 };
 
@@ -20,18 +20,15 @@
 #ifndef DBWATCHTABLE_H
 #define DBWATCHTABLE_H
 #include "DBTable.h"
+#include <functional>
+#include <algorithm>
+#include <utility>
 
 #define PRIMARY_INDEX "PRIMARY"
 
 typedef std::vector<NdbDictionary::Event::TableEvent> TEventVec;
 typedef typename TEventVec::size_type evtvec_size_type;
 
-template<typename TableRow>
-struct EpochsRowsMap{
-  std::vector<Uint64>* mEpochs;
-  boost::unordered_map<Uint64,std::queue<TableRow>* >* mRowsByEpoch;
-};
-
 enum LogType{
   FSLOG,
   METALOG,
@@ -41,11 +38,60 @@ enum LogType{
 };
 
 struct LogHandler{
+  // epoch of the log row, 0 if unknown
+  Uint64 mEpoch = 0;
+
   virtual void removeLog(Ndb* connection) const= 0;
   virtual LogType getType() const = 0;
   virtual std::string getDescription() const = 0;
 };
 
+// keys read per round trip during recovery, if no batch is set
+#define RECOVERY_READ_BATCH 1000
+
+/*
+ * primary keys of the rows to recover, each with the epoch of its row.
+ * Once sorted by epoch, the keys of an epoch stay in the order they were
+ * scanned in
+ */
+struct RecoveryKeys {
+  std::vector<char> mKeys;
+  std::vector<std::pair<Uint64, std::size_t> > mEpochs;
+  Uint32 mLength;
+
+  RecoveryKeys(Uint32 length) : mLength(length) {
+  }
+
+  void add(Uint64 epoch, const char* key) {
+    mEpochs.push_back(std::make_pair(epoch, mEpochs.size()));
+    mKeys.insert(mKeys.end(), key, key + mLength);
+  }
+
+  void append(RecoveryKeys& keys) {
+    for (auto& epoch : keys.mEpochs) {
+      add(epoch.first, keys.mKeys.data() + epoch.second * mLength);
+    }
+    keys.mEpochs.clear();
+    keys.mKeys.clear();
+  }
+
+  void sort() {
+    std::sort(mEpochs.begin(), mEpochs.end());
+  }
+
+  std::size_t size() const {
+    return mEpochs.size();
+  }
+
+  Uint64 getEpoch(std::size_t i) const {
+    return mEpochs[i].first;
+  }
+
+  const char* getKey(std::size_t i) const {
+    return mKeys.data() + mEpochs[i].second * mLength;
+  }
+};
+
 template<typename TableRow>
 class DBWatchTable : public DBTable<TableRow> {
 public:
@@ -53,28 +99,43 @@ public:
   DBWatchTable(const std::string table, DBTableBase* companionTable);
   evtvec_size_type getNoEvents() const;
   NdbDictionary::Event::TableEvent getEvent(evtvec_size_type index) const;
-  EpochsRowsMap<TableRow> getAllForRecovery(Ndb* connection);
+  bool needsPreImage() const;
+  bool needsPostImage() const;
+  bool isEventMergingEnabled() const;
+
+  typedef std::function<void(Uint64 epoch, std::vector<TableRow>& rows)> EpochRowsHandler;
+  void getAllForRecovery(std::vector<Ndb*>& connections, Uint64 after_epoch,
+      Uint32 max_rows, EpochRowsHandler handler);
   virtual ~DBWatchTable();
-  virtual std::string getPKStr(TableRow row);
+  using DBTable<TableRow>::getRow;
+  virtual typename TableRow::Key getKey(const TableRow& row);
+  virtual void setEpoch(TableRow& row, Uint64 epoch);
   virtual LogHandler* getLogRemovalHandler(TableRow row);
 
 private:
   TEventVec mWatchEvents;
   std::string mRecoveryIndex;
+  bool mMergeEvents;
+
+  bool isWatched(NdbDictionary::Event::TableEvent event) const;
+  void scanPartitionsForRecovery(std::vector<Ndb*>& connections,
+      Uint64 after_epoch, RecoveryKeys& keys);
 
 protected:
   void addWatchEvent(NdbDictionary::Event::TableEvent event);
   void addRecoveryIndex(const std::string recovery);
+  void enableEventMerging();
 
 };
 
 template<typename TableRow>
-DBWatchTable<TableRow>::DBWatchTable(const std::string table) : DBTable<TableRow>(table) {
+DBWatchTable<TableRow>::DBWatchTable(const std::string table) : DBTable<TableRow>(table),
+mMergeEvents(false) {
 }
 
 template<typename TableRow>
 DBWatchTable<TableRow>::DBWatchTable(const std::string table, DBTableBase* companionTable) :
-DBTable<TableRow>(table, companionTable) {
+DBTable<TableRow>(table, companionTable), mMergeEvents(false) {
 }
 
 template<typename TableRow>
@@ -95,6 +156,42 @@ NdbDictionary::Event::TableEvent DBWatchTable<TableRow>::getEvent(evtvec_size_ty
   return NdbDictionary::Event::TE_INSERT;
 }
 
+template<typename TableRow>
+bool DBWatchTable<TableRow>::isWatched(NdbDictionary::Event::TableEvent event) const {
+  return std::find(mWatchEvents.begin(), mWatchEvents.end(), event)
+      != mWatchEvents.end();
+}
+
+/*
+ * the images requested from the event buffer follow the watched events,
+ * deletes only carry the row before and inserts only the row after
+ */
+template<typename TableRow>
+bool DBWatchTable<TableRow>::needsPreImage() const {
+  return isWatched(NdbDictionary::Event::TE_DELETE)
+      || isWatched(NdbDictionary::Event::TE_UPDATE);
+}
+
+template<typename TableRow>
+bool DBWatchTable<TableRow>::needsPostImage() const {
+  return isWatched(NdbDictionary::Event::TE_INSERT)
+      || isWatched(NdbDictionary::Event::TE_UPDATE);
+}
+
+/*
+ * merge the operations on the same primary key within an epoch into one
+ * event, only for tables where the tailer does not need every operation
+ */
+template<typename TableRow>
+void DBWatchTable<TableRow>::enableEventMerging() {
+  mMergeEvents = true;
+}
+
+template<typename TableRow>
+bool DBWatchTable<TableRow>::isEventMergingEnabled() const {
+  return mMergeEvents;
+}
+
 template<typename TableRow>
 void DBWatchTable<TableRow>::addRecoveryIndex(const std::string recovery) {
   mRecoveryIndex = recovery;
@@ -104,57 +201,126 @@ template<typename TableRow>
 DBWatchTable<TableRow>::~DBWatchTable() {
 }
 
+/*
+ * hands the rows written after after_epoch to the handler one epoch at a
+ * time, in epoch order. The row epoch is a pseudo column without an index,
+ * so a single scan reads only the primary key and the epoch of every row.
+ * Sorted by epoch, the rows are then read back by key max_rows at a time,
+ * RECOVERY_READ_BATCH if not set. Besides the keys only the rows of the
+ * epoch at hand are held. Rows written after the scan are left to the
+ * events and rows removed since are skipped. With more than one connection
+ * the partitions are scanned in parallel, unless the rows have to come
+ * sorted by the recovery index
+ */
 template<typename TableRow>
-EpochsRowsMap<TableRow> DBWatchTable<TableRow>::getAllForRecovery(Ndb* connection) {
-  typedef boost::unordered_map<Uint64, std::queue<TableRow>* > EpochRows;
-  typedef typename EpochRows::iterator EpochRowIterator;
-
+void DBWatchTable<TableRow>::getAllForRecovery(std::vector<Ndb*>& connections,
+    Uint64 after_epoch, Uint32 max_rows, EpochRowsHandler handler) {
   ptime start = Utils::getCurrentTime();
 
   this->setReadEpoch(true);
 
-  EpochRows* rowsByEpoch = new EpochRows();
-  std::vector<Uint64>* epochs = new std::vector<Uint64>();
-
-  if(mRecoveryIndex != ""){
-    LOG_DEBUG("Read all for " << this->getName() << " recovery sorted by " <<
-    mRecoveryIndex);
-    this->getAll(connection, mRecoveryIndex);
-  }else{
-    LOG_DEBUG("Read all for " << this->getName() << " recovery");
-    this->getAll(connection);
+  bool parallel = connections.size() > 1 && mRecoveryIndex == "";
+  RecoveryKeys keys(this->prepareKeyScan(connections[0]));
+  if (parallel) {
+    scanPartitionsForRecovery(connections, after_epoch, keys);
+  } else {
+    LOG_DEBUG("Read all keys for " << this->getName() << " recovery after epoch "
+        << after_epoch << (mRecoveryIndex != "" ? " sorted by " : "")
+        << mRecoveryIndex);
+    this->scanKeys(connections[0], mRecoveryIndex, boost::none,
+        [&keys, after_epoch](Uint64 epoch, const char* key) {
+      if (epoch > after_epoch) {
+        keys.add(epoch, key);
+      }
+    });
   }
+  keys.sort();
+  ptime scanned = Utils::getCurrentTime();
 
-  while (this->next()) {
-    TableRow row = this->currRow();
-    Uint64 epoch = this->currEpoch();
-
-    EpochRowIterator curr = rowsByEpoch->find(epoch);
-    std::queue<TableRow>* currRows;
-    if (curr == rowsByEpoch->end()) {
-      currRows = new std::queue<TableRow>();
-      rowsByEpoch->emplace(epoch, currRows);
-      epochs->push_back(epoch);
-    } else {
-      currRows = curr->second;
+  Uint32 batch = max_rows > 0 ? max_rows : RECOVERY_READ_BATCH;
+  Uint64 totalRows = 0;
+  int reads = 0;
+  Uint64 epoch = 0;
+  std::vector<TableRow> rows;
+  std::vector<const char*> batchKeys;
+  for (std::size_t next = 0; next < keys.size(); reads++) {
+    std::size_t end = std::min(keys.size(), next + batch);
+    batchKeys.clear();
+    for (std::size_t i = next; i < end; i++) {
+      batchKeys.push_back(keys.getKey(i));
     }
-    currRows->push(row);
+    this->readKeys(connections[0], batchKeys, [&](StagedRecAttr** values) {
+      Uint64 keyEpoch = keys.getEpoch(next++);
+      if (keyEpoch != epoch && !rows.empty()) {
+        handler(epoch, rows);
+        rows.clear();
+      }
+      epoch = keyEpoch;
+      if (values != nullptr) {
+        rows.push_back(this->getRow(values));
+        totalRows++;
+      }
+    });
+  }
+  if (!rows.empty()) {
+    handler(epoch, rows);
   }
 
   this->setReadEpoch(false);
 
-  std::sort(epochs->begin(), epochs->end());
+  LOG_INFO("ePipe done reading " << totalRows << " rows for " << this->getName()
+  << " recovery, the keys of " << keys.size() << " rows scanned in "
+  << Utils::getTimeDiffInMilliseconds(start, scanned) << " msec on "
+  << (parallel ? connections.size() : 1) << " threads and read back in "
+  << reads << " batches in "
+  << Utils::getTimeDiffInMilliseconds(scanned, Utils::getCurrentTime()) << " msec");
+}
 
-  LOG_DEBUG("ePipe done reading/sorting for " << this->getName()
-  << " recovery in " << Utils::getTimeDiffInMilliseconds(start, Utils::getCurrentTime()) << " msec");
+/*
+ * every connection scans the keys of its share of the partitions on a
+ * thread of its own
+ */
+template<typename TableRow>
+void DBWatchTable<TableRow>::scanPartitionsForRecovery(
+    std::vector<Ndb*>& connections, Uint64 after_epoch, RecoveryKeys& keys) {
+  Uint32 partitions = this->getNoPartitions(connections[0]);
+  Uint32 threads = connections.size();
+  LOG_DEBUG("Read all keys for " << this->getName() << " recovery after epoch "
+  << after_epoch << ", " << partitions << " partitions on "
+  << threads << " threads");
+
+  std::vector<RecoveryKeys> partitionKeys(threads, RecoveryKeys(keys.mLength));
+  boost::thread_group scanners;
+  for (Uint32 i = 0; i < threads; i++) {
+    scanners.create_thread([this, i, threads, partitions, after_epoch,
+        &connections, &partitionKeys]() {
+      RecoveryKeys& own = partitionKeys[i];
+      for (Uint32 partition = i; partition < partitions; partition += threads) {
+        this->scanKeys(connections[i], "", partition,
+            [&own, after_epoch](Uint64 epoch, const char* key) {
+          if (epoch > after_epoch) {
+            own.add(epoch, key);
+          }
+        });
+        LOG_DEBUG(this->getName() << " -- Scanned the keys of partition "
+            << partition);
+      }
+    });
+  }
+  scanners.join_all();
 
-  EpochsRowsMap<TableRow> map {epochs, rowsByEpoch};
-  return map;
+  for (auto& own : partitionKeys) {
+    keys.append(own);
+  }
+}
+
+template<typename TableRow>
+typename TableRow::Key DBWatchTable<TableRow>::getKey(const TableRow& row) {
+  return typename TableRow::Key();
 }
 
 template<typename TableRow>
-std::string DBWatchTable<TableRow>::getPKStr(TableRow row) {
-  return "";
+void DBWatchTable<TableRow>::setEpoch(TableRow& row, Uint64 epoch) {
 }
 
 template<typename TableRow>
@@ -132,6 +132,15 @@ public:
   }
 
   DatasetRow getRow(NdbRecAttr* values[]) {
+    return readRow(values);
+  }
+
+  DatasetRow getRow(StagedRecAttr* values[]) {
+    return readRow(values);
+  }
+
+  template<typename RecAttr>
+  DatasetRow readRow(RecAttr* values[]) {
     DatasetRow row;
     row.mId = values[0]->int32_value();
     row.mInodeId = values[1]->int64_value();
@@ -194,8 +203,18 @@ public:
       AnyMap args;
       //DatasetInodeId
       args[1] = dataset_inode_id;
-      
-      DatasetVec datasets = doRead(connection, getColumn(1), args);
+
+      // only the inode id, name and project are used, skip the other columns
+      static const Projection projection = {1, 3, 4};
+      DatasetVec datasets;
+      doRead(connection, getColumn(1), args, boost::none, projection,
+          [this, &datasets](NdbRecAttr** values) {
+        DatasetRow row;
+        row.mInodeId = values[1]->int64_value();
+        row.mInodeName = get_string(values[3]);
+        row.mProjectId = values[4]->int32_value();
+        datasets.push_back(row);
+      });
 
       UISet projectIds;
       for (DatasetVec::iterator it = datasets.begin(); it != datasets.end(); ++it) {
@@ -17,12 +17,13 @@
 #ifndef FILEPROVENANCELOGTABLE_H
 #define FILEPROVENANCELOGTABLE_H
 #include "DBWatchTable.h"
+#include <tuple>
 #include "rapidjson/writer.h"
 #include "rapidjson/stringbuffer.h"
 #include "rapidjson/document.h"
 
 #include "ConcurrentPriorityQueue.h"
-#include "ConcurrentQueue.h"
+#include "ConcurrentRingBuffer.h"
 #include "XAttrTable.h"
 #include "FileProvenanceXAttrBufferTable.h"
 #include "FileProvenanceConstantsRaw.h"
@@ -71,6 +72,9 @@ struct FileProvenancePK {
 };
 
 struct FileProvenanceRow {
+  typedef PKKey<Int64, std::string, int, Int64, std::string, int,
+      std::string> Key;
+
   Int64 mInodeId;
   std::string mOperation;
   int mLogicalTime;
@@ -97,6 +101,22 @@ struct FileProvenanceRow {
   Int16 mXAttrNumParts;
 
   ptime mEventCreationTime;
+  // epoch the tailer received the row in
+  Uint64 mEpoch = 0;
+
+  Uint64 getByteSize() const {
+    return sizeof(FileProvenanceRow) + Utils::getHeapBytes(mOperation)
+        + Utils::getHeapBytes(mAppId) + Utils::getHeapBytes(mTieBreaker)
+        + Utils::getHeapBytes(mInodeName) + Utils::getHeapBytes(mProjectName)
+        + Utils::getHeapBytes(mDatasetName) + Utils::getHeapBytes(mP1Name)
+        + Utils::getHeapBytes(mP2Name) + Utils::getHeapBytes(mParentName)
+        + Utils::getHeapBytes(mUserName) + Utils::getHeapBytes(mXAttrName);
+  }
+
+  Key getKey() const {
+    return Key(mInodeId, mOperation, mLogicalTime, mTimestamp, mAppId, mUserId,
+        mTieBreaker);
+  }
 
   FileProvenancePK getPK() {
     return FileProvenancePK(mInodeId, mOperation, mLogicalTime, mTimestamp, mAppId, mUserId, mTieBreaker);
@@ -163,34 +183,32 @@ struct FileProvenanceRowHash {
   }
 };
 
+/*
+ * true if r1 is processed after r2. Rows are ordered lexicographically on
+ * (dataset, dataset logical time, phase, inode, logical time). Within a
+ * dataset logical time the dataset xattr attach comes first and the delete
+ * dataset last. The dataset logical time of the operations on an inode
+ * does not go back, so the operations on one inode stay in logical time
+ * order.
+ */
 struct FileProvenanceRowComparator {
 
   bool operator()(const FileProvenanceRow &r1, const FileProvenanceRow &r2) const {
-    if (r1.mInodeId == r2.mInodeId) {
-      return r1.mLogicalTime > r2.mLogicalTime;
+    const int phase1 = getPhase(r1);
+    const int phase2 = getPhase(r2);
+    return std::tie(r1.mDatasetId, r1.mDatasetLogicalTime, phase1, r1.mInodeId,
+        r1.mLogicalTime) > std::tie(r2.mDatasetId, r2.mDatasetLogicalTime,
+        phase2, r2.mInodeId, r2.mLogicalTime);
+  }
+
+  int getPhase(const FileProvenanceRow &r) const {
+    if (isDatasetProvCore(r)) {
+      return 0;
     }
-    if(r1.mDatasetId == r2.mDatasetId) {
-      if(r1.mDatasetLogicalTime == r2.mDatasetLogicalTime) {
-        //if both operations work on a dataset and have the same logical time
-        //delete dataset should be last operation processed in epoch for this dataset logical time
-        if(isDeleteDataset(r1)) {
-          return true;
-        }
-        if(isDeleteDataset(r2)) {
-          return false;
-        }
-        //dataset xattr attach should be first operation processed in epoch for this dataset logical time
-        if(isDatasetProvCore(r1)) {
-          return false;
-        }
-        if(isDatasetProvCore(r2)) {
-          return true;
-        }
-      } else {
-        return r1.mDatasetLogicalTime > r2.mDatasetLogicalTime;
-      }
+    if (isDeleteDataset(r)) {
+      return 2;
     }
-    return r1.mInodeId > r2.mInodeId;
+    return 1;
   }
 
   bool isDeleteDataset(const FileProvenanceRow &r) const {
@@ -205,8 +223,7 @@ struct FileProvenanceRowComparator {
   }
 };
 
-typedef ConcurrentQueue<FileProvenanceRow> CPRq;
-typedef boost::heap::priority_queue<FileProvenanceRow, boost::heap::compare<FileProvenanceRowComparator> > PRpq;
+typedef ConcurrentRingBuffer<FileProvenanceRow> CPRq;
 typedef std::vector <boost::optional<FileProvenancePK> > PKeys;
 typedef std::vector <FileProvenanceRow> Pq;
 
@@ -300,6 +317,15 @@ public:
   }
 
   FileProvenanceRow getRow(NdbRecAttr* value[]) {
+    return readRow(value);
+  }
+
+  FileProvenanceRow getRow(StagedRecAttr* value[]) {
+    return readRow(value);
+  }
+
+  template<typename RecAttr>
+  FileProvenanceRow readRow(RecAttr* value[]) {
     FileProvenanceRow row;
     row.mEventCreationTime = Utils::getCurrentTime();
     row.mInodeId = value[0]->int64_value();
@@ -351,8 +377,12 @@ public:
     }
   }
 
-  std::string getPKStr(FileProvenanceRow row) {
-    return row.getPK().to_string();
+  FileProvenanceRow::Key getKey(const FileProvenanceRow& row) override {
+    return row.getKey();
+  }
+
+  void setEpoch(FileProvenanceRow& row, Uint64 epoch) override {
+    row.mEpoch = epoch;
   }
 
   LogHandler* getLogHandler(FileProvenancePK pk, boost::optional<FPXAttrBufferPK> bufferPK) {
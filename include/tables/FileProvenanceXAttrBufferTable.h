@@ -299,6 +299,15 @@ public:
   }
 
   FPXAttrBufferRowPart getRow(NdbRecAttr* values[]) {
+    return readRow(values);
+  }
+
+  FPXAttrBufferRowPart getRow(StagedRecAttr* values[]) {
+    return readRow(values);
+  }
+
+  template<typename RecAttr>
+  FPXAttrBufferRowPart readRow(RecAttr* values[]) {
     FPXAttrBufferRowPart row;
     row.mInodeId = values[0]->int64_value();
     row.mNamespace = values[1]->int8_value();
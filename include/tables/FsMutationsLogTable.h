@@ -22,7 +22,8 @@
 
 #include "DBWatchTable.h"
 #include "ConcurrentPriorityQueue.h"
-#include "ConcurrentQueue.h"
+#include "ConcurrentRingBuffer.h"
+#include "RadixSort.h"
 
 enum FsOpType {
   FsAdd = 0,
@@ -75,6 +76,8 @@ struct FsMutationPK {
 };
 
 struct FsMutationRow {
+  typedef PKKey<Int64, Int64, int> Key;
+
   Int64 mDatasetINodeId;
   Int64 mInodeId;
   int mLogicalTime;
@@ -88,15 +91,20 @@ struct FsMutationRow {
   std::string mInodeName;
 
   ptime mEventCreationTime;
+  // epoch the tailer received the row in
+  Uint64 mEpoch = 0;
 
   FsMutationPK getPK() {
     return FsMutationPK(mDatasetINodeId, mInodeId, mLogicalTime);
   }
 
-  std::string getPKStr(){
-    std::stringstream stream;
-    stream << mDatasetINodeId << "-" << mInodeId << "-" << mLogicalTime;
-    return stream.str();
+  Uint64 getByteSize() const {
+    return sizeof(FsMutationRow) + Utils::getHeapBytes(mPk3)
+        + Utils::getHeapBytes(mInodeName);
+  }
+
+  Key getKey() const {
+    return Key(mDatasetINodeId, mInodeId, mLogicalTime);
   }
 
   std::string to_string() {
@@ -196,10 +204,23 @@ struct FsMutationRowComparator {
   }
 };
 
+/*
+ * radix key ordering the rows of an epoch by (inodeId, logicalTime), the
+ * same order FsMutationRowComparator gives
+ */
+struct FsMutationRowRadixKey {
+
+  RadixKey operator()(const FsMutationRow &r) const {
+    RadixKey key;
+    key.mHigh = radix_key(r.mInodeId);
+    key.mLow = radix_key(r.mLogicalTime);
+    return key;
+  }
+};
+
 //typedef ConcurrentPriorityQueue<FsMutationRow, FsMutationRowComparator> CFSpq;
 typedef std::vector<FsMutationRow> Fmq;
-typedef ConcurrentQueue<FsMutationRow> CFSq;
-typedef boost::heap::priority_queue<FsMutationRow, boost::heap::compare<FsMutationRowComparator> > FSpq;
+typedef ConcurrentRingBuffer<FsMutationRow> CFSq;
 typedef std::vector<FsMutationPK> FPK;
 
 typedef std::vector<FsMutationRow> FSv;
@@ -239,9 +260,21 @@ public:
     addColumn("inode_parent_id");
     addColumn("inode_name");
     addWatchEvent(NdbDictionary::Event::TE_INSERT);
+    // every mutation has its own logical time, merging only collapses
+    // repeated operations on the same log row
+    enableEventMerging();
   }
 
   FsMutationRow getRow(NdbRecAttr* value[]) {
+    return readRow(value);
+  }
+
+  FsMutationRow getRow(StagedRecAttr* value[]) {
+    return readRow(value);
+  }
+
+  template<typename RecAttr>
+  FsMutationRow readRow(RecAttr* value[]) {
     FsMutationRow row;
     row.mEventCreationTime = Utils::getCurrentTime();
     row.mDatasetINodeId = value[0]->int64_value();
@@ -282,12 +315,18 @@ public:
     }
   }
 
-  std::string getPKStr(FsMutationRow row) override {
-    return row.getPKStr();
+  FsMutationRow::Key getKey(const FsMutationRow& row) override {
+    return row.getKey();
+  }
+
+  void setEpoch(FsMutationRow& row, Uint64 epoch) override {
+    row.mEpoch = epoch;
   }
 
   LogHandler* getLogRemovalHandler(FsMutationRow row) override {
-    return new FSLogHandler(row.getPK());
+    LogHandler* handler = new FSLogHandler(row.getPK());
+    handler->mEpoch = row.mEpoch;
+    return handler;
   }
 private:
 
@@ -50,6 +50,15 @@ public:
   }
 
   GroupRow getRow(NdbRecAttr* values[]) {
+    return readRow(values);
+  }
+
+  GroupRow getRow(StagedRecAttr* values[]) {
+    return readRow(values);
+  }
+
+  template<typename RecAttr>
+  GroupRow readRow(RecAttr* values[]) {
     GroupRow row;
     row.mId = values[0]->int32_value();
     row.mName = get_string(values[1]);
@@ -61,6 +61,8 @@ inline static const char* HopsworksOpTypeToStr(HopsworksOpType optype) {
 }
 
 struct HopsworksOpRow {
+  typedef PKKey<int> Key;
+
   int mId;
   int mOpId;
   OpsLogOn mOpOn;
@@ -68,6 +70,8 @@ struct HopsworksOpRow {
   int mProjectId;
   Int64 mDatasetINodeId;
   Int64 mInodeId;
+  // epoch the tailer received the row in
+  Uint64 mEpoch = 0;
 
   std::string to_string() {
     std::stringstream out;
@@ -116,6 +120,15 @@ public:
   }
 
   HopsworksOpRow getRow(NdbRecAttr* value[]) {
+    return readRow(value);
+  }
+
+  HopsworksOpRow getRow(StagedRecAttr* value[]) {
+    return readRow(value);
+  }
+
+  template<typename RecAttr>
+  HopsworksOpRow readRow(RecAttr* value[]) {
     HopsworksOpRow row;
     row.mId = value[0]->int32_value();
     //op_id is the dataset_id or project_id or schema_id depending on the operation type
@@ -147,12 +160,18 @@ public:
     }
   }
 
-  std::string getPKStr(HopsworksOpRow row) override {
-    return std::to_string(row.mId);
+  HopsworksOpRow::Key getKey(const HopsworksOpRow& row) override {
+    return HopsworksOpRow::Key(row.mId);
+  }
+
+  void setEpoch(HopsworksOpRow& row, Uint64 epoch) override {
+    row.mEpoch = epoch;
   }
 
   LogHandler* getLogRemovalHandler(HopsworksOpRow row) override {
-    return new HopsworksLogHandler(row.mId);
+    LogHandler* handler = new HopsworksLogHandler(row.mId);
+    handler->mEpoch = row.mEpoch;
+    return handler;
   }
 
 private:
@@ -38,6 +38,15 @@ public:
   }
 
   INodeDatasetLookupRow getRow(NdbRecAttr* values[]) {
+    return readRow(values);
+  }
+
+  INodeDatasetLookupRow getRow(StagedRecAttr* values[]) {
+    return readRow(values);
+  }
+
+  template<typename RecAttr>
+  INodeDatasetLookupRow readRow(RecAttr* values[]) {
     INodeDatasetLookupRow row;
     row.mInodeId = values[0]->int64_value();
     row.mDatasetINodeId = values[1]->int64_value();
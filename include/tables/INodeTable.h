@@ -212,6 +212,9 @@ struct INodeRow {
 
 typedef boost::unordered_map<Int64, INodeRow> INodeMap;
 typedef std::vector<INodeRow> INodeVec;
+// parent_id, name, partition_id
+typedef PKKey<Int64, std::string, Int64> INodeKey;
+typedef std::vector<INodeKey> INodeKeyVec;
 
 class INodeTable : public DBTable<INodeRow> {
 public:
@@ -232,6 +235,15 @@ public:
   }
 
   INodeRow getRow(NdbRecAttr* values[]) {
+    return readRow(values);
+  }
+
+  INodeRow getRow(StagedRecAttr* values[]) {
+    return readRow(values);
+  }
+
+  template<typename RecAttr>
+  INodeRow readRow(RecAttr* values[]) {
     INodeRow row;
     row.mParentId = values[0]->int64_value();
     row.mName = get_string(values[1]);
@@ -264,9 +276,7 @@ public:
 
   // This method should be avoid as much as possible since it triggers an index scan
   INodeRow getByInodeId(Ndb* connection, Int64 inodeId) {
-    AnyMap key;
-    key[3] = inodeId;
-    INodeVec inodes = doRead(connection, "inode_idx", key);
+    INodeVec inodes = doRead(connection, "inode_idx", PKKey<Int64>(inodeId));
     INodeRow row;
     if (inodes.size() > 1) {
       LOG_ERROR("INodeId must be unique, got " << inodes.size()
@@ -296,8 +306,12 @@ public:
     return inodes;
   }
 
+  INodeVec get(Ndb* connection, INodeKeyVec& pks){
+    return doRead(connection, pks);
+  }
+
   INodeMap get(Ndb* connection, Fmq* data_batch) {
-    AnyVec anyVec;
+    INodeKeyVec keys;
     boost::unordered_map<Int64, FsMutationRow> mutationsByInode;
     for (Fmq::iterator it = data_batch->begin(); it != data_batch->end(); ++it) {
       FsMutationRow row = *it;
@@ -306,14 +320,11 @@ public:
       }
       mutationsByInode[row.mInodeId] = row;
 
-      AnyMap pk;
-      pk[0] = row.getParentId();
-      pk[1] = row.getINodeName();
-      pk[2] = row.getPartitionId();
-      anyVec.push_back(pk);
+      keys.push_back(INodeKey(row.getParentId(), row.getINodeName(),
+          row.getPartitionId()));
     }
 
-    INodeVec inodes = doRead(connection, anyVec);
+    INodeVec inodes = doRead(connection, keys);
 
     UISet user_ids, group_ids;
     for (INodeVec::iterator it = inodes.begin(); it != inodes.end(); ++it) {
@@ -71,6 +71,15 @@ public:
   }
 
   FieldRow getRow(NdbRecAttr* values[]) {
+    return readRow(values);
+  }
+
+  FieldRow getRow(StagedRecAttr* values[]) {
+    return readRow(values);
+  }
+
+  template<typename RecAttr>
+  FieldRow readRow(RecAttr* values[]) {
     FieldRow row;
     row.mId = values[0]->int32_value();
     row.mName = get_string(values[1]);
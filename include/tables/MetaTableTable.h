@@ -45,6 +45,15 @@ public:
   }
 
   TableRow getRow(NdbRecAttr* values[]) {
+    return readRow(values);
+  }
+
+  TableRow getRow(StagedRecAttr* values[]) {
+    return readRow(values);
+  }
+
+  template<typename RecAttr>
+  TableRow readRow(RecAttr* values[]) {
     TableRow row;
     row.mId = values[0]->int32_value();
     row.mName = get_string(values[1]);
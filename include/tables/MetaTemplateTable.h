@@ -89,6 +89,15 @@ public:
   }
 
   TemplateRow getRow(NdbRecAttr* values[]) {
+    return readRow(values);
+  }
+
+  TemplateRow getRow(StagedRecAttr* values[]) {
+    return readRow(values);
+  }
+
+  template<typename RecAttr>
+  TemplateRow readRow(RecAttr* values[]) {
     TemplateRow row;
     row.mId = values[0]->int32_value();
     row.mName = get_string(values[1]);
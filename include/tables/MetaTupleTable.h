@@ -43,6 +43,15 @@ public:
   }
 
   TupleRow getRow(NdbRecAttr* values[]) {
+    return readRow(values);
+  }
+
+  TupleRow getRow(StagedRecAttr* values[]) {
+    return readRow(values);
+  }
+
+  template<typename RecAttr>
+  TupleRow readRow(RecAttr* values[]) {
     TupleRow row;
     row.mId = values[0]->int32_value();
     row.mInodeId = values[1]->int64_value();
@@ -26,6 +26,8 @@
 #define XATTR_FIELD_NAME "xattr"
 
 struct MetadataKey {
+  typedef PKKey<Int32, Int32, Int32> Key;
+
   Int32 mId;
   Int32 mFieldId;
   Int32 mTupleId;
@@ -44,10 +46,12 @@ struct MetadataKey {
     .mTupleId);
   }
 
+  Key getKey() const {
+    return Key(mId, mTupleId, mFieldId);
+  }
+
   std::string getPKStr(){
-    std::stringstream stream;
-    stream << mId << "-" << mTupleId << "-" << mFieldId;
-    return stream.str();
+    return getKey().to_string();
   }
 };
 
@@ -63,11 +67,18 @@ struct MetadataKeyHasher {
 };
 
 struct MetadataLogEntry {
+  typedef MetadataKey::Key Key;
+
   Int32 mId;
   MetadataKey mMetaPK;
   HopsworksOpType mMetaOpType;
   ptime mEventCreationTime;
 
+  // none of the fields, the key included, holds heap memory
+  Uint64 getByteSize() const {
+    return sizeof(MetadataLogEntry);
+  }
+
   std::string to_string() {
     std::stringstream stream;
     stream << "-------------------------" << std::endl;
@@ -86,6 +97,8 @@ struct MetadataLogEntryComparator {
   }
 };
 
+// ordered by log id across barriers, a log row can commit in a later epoch
+// than a row with a higher id
 typedef ConcurrentPriorityQueue<MetadataLogEntry, MetadataLogEntryComparator> CMetaQ;
 typedef std::vector<MetadataLogEntry> MetaQ;
 
@@ -119,6 +132,15 @@ public:
   }
 
   MetadataLogEntry getRow(NdbRecAttr* value[]) {
+    return readRow(value);
+  }
+
+  MetadataLogEntry getRow(StagedRecAttr* value[]) {
+    return readRow(value);
+  }
+
+  template<typename RecAttr>
+  MetadataLogEntry readRow(RecAttr* value[]) {
     MetadataLogEntry row;
     row.mEventCreationTime = Utils::getCurrentTime();
     row.mId = value[0]->int32_value();
@@ -149,8 +171,8 @@ public:
     }
   }
 
-  std::string getPKStr(MetadataLogEntry row) override {
-    return row.mMetaPK.getPKStr();
+  MetadataKey::Key getKey(const MetadataLogEntry& row) override {
+    return row.mMetaPK.getKey();
   }
 
   LogHandler* getLogRemovalHandler(MetadataLogEntry row) override {
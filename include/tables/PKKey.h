@@ -0,0 +1,101 @@
+/*
+ * This file is part of ePipe
+ * Copyright (C) 2019, Logical Clocks AB. All rights reserved
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef PKKEY_H
+#define PKKEY_H
+#include "Utils.h"
+#include <tuple>
+
+/*
+ * primary key of a table row kept as its typed columns. Hashing and
+ * comparing go over the columns directly, so keys can be used in unordered
+ * containers without formatting them into strings first
+ */
+template<typename... Columns>
+struct PKKey {
+  std::tuple<Columns...> mColumns;
+
+  PKKey() {
+  }
+
+  template<typename... Values, typename = typename std::enable_if<
+      sizeof...(Values) != 0 && std::is_constructible<std::tuple<Columns...>,
+      Values&&...>::value>::type>
+  PKKey(Values&&... values) : mColumns(std::forward<Values>(values)...) {
+  }
+
+  template<std::size_t I>
+  const typename std::tuple_element<I, std::tuple<Columns...>>::type& get() const {
+    return std::get<I>(mColumns);
+  }
+
+  bool operator==(const PKKey& other) const {
+    return mColumns == other.mColumns;
+  }
+
+  bool operator!=(const PKKey& other) const {
+    return !(*this == other);
+  }
+
+  std::size_t hash() const {
+    std::size_t seed = 0;
+    hashColumns(seed, std::index_sequence_for<Columns...>());
+    return seed;
+  }
+
+  std::string to_string() const {
+    std::stringstream out;
+    appendColumns(out, std::index_sequence_for<Columns...>());
+    return out.str();
+  }
+
+private:
+  template<std::size_t... I>
+  void hashColumns(std::size_t& seed, std::index_sequence<I...>) const {
+    int expand[] = {0, (boost::hash_combine(seed, std::get<I>(mColumns)), 0)...};
+    (void) expand;
+  }
+
+  template<std::size_t... I>
+  void appendColumns(std::stringstream& out, std::index_sequence<I...>) const {
+    int expand[] = {0, (appendColumn(out, I, std::get<I>(mColumns)), 0)...};
+    (void) expand;
+  }
+
+  template<typename Column>
+  static void appendColumn(std::stringstream& out, std::size_t index,
+      const Column& column) {
+    if (index > 0) {
+      out << "-";
+    }
+    out << column;
+  }
+
+  static void appendColumn(std::stringstream& out, std::size_t index,
+      const Int8& column) {
+    appendColumn(out, index, static_cast<int>(column));
+  }
+};
+
+template<typename... Columns>
+std::size_t hash_value(const PKKey<Columns...>& key) {
+  return key.hash();
+}
+
+#endif /* PKKEY_H */
@@ -130,6 +130,15 @@ public:
   }
 
   ProjectRow getRow(NdbRecAttr* values[]) {
+    return readRow(values);
+  }
+
+  ProjectRow getRow(StagedRecAttr* values[]) {
+    return readRow(values);
+  }
+
+  template<typename RecAttr>
+  ProjectRow readRow(RecAttr* values[]) {
     ProjectRow row;
     row.mId = values[0]->int32_value();
     row.mInodeParentId = values[1]->int64_value();
@@ -0,0 +1,63 @@
+/*
+ * This file is part of ePipe
+ * Copyright (C) 2019, Logical Clocks AB. All rights reserved
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef RECATTRARENA_H
+#define RECATTRARENA_H
+#include "Utils.h"
+
+#define REC_ATTR_ARENA_BLOCK 4096
+
+/*
+ * hands out the NdbRecAttr arrays of the operations of a transaction. The
+ * arrays are carved out of blocks that are never resized, so the ones
+ * handed out stay valid until reset, and the blocks are kept for the next
+ * transaction instead of being freed
+ */
+class RecAttrArena {
+public:
+  RecAttrArena() : mBlock(0), mUsed(0) {
+  }
+
+  NdbRecAttr** allocate(Uint32 size) {
+    while (mBlock < mBlocks.size()
+        && mUsed + size > mBlocks[mBlock].size()) {
+      mBlock++;
+      mUsed = 0;
+    }
+    if (mBlock == mBlocks.size()) {
+      mBlocks.emplace_back(std::max<Uint32>(REC_ATTR_ARENA_BLOCK, size));
+      mUsed = 0;
+    }
+    NdbRecAttr** values = mBlocks[mBlock].data() + mUsed;
+    mUsed += size;
+    return values;
+  }
+
+  void reset() {
+    mBlock = 0;
+    mUsed = 0;
+  }
+
+private:
+  std::vector<std::vector<NdbRecAttr*> > mBlocks;
+  std::size_t mBlock;
+  Uint32 mUsed;
+};
+
+#endif /* RECATTRARENA_H */
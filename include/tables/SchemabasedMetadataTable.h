@@ -201,6 +201,15 @@ public:
   }
 
   SchemabasedMetadataEntry getRow(NdbRecAttr* values[]) {
+    return readRow(values);
+  }
+
+  SchemabasedMetadataEntry getRow(StagedRecAttr* values[]) {
+    return readRow(values);
+  }
+
+  template<typename RecAttr>
+  SchemabasedMetadataEntry readRow(RecAttr* values[]) {
     SchemabasedMetadataEntry row;
     row.mId = values[0]->int32_value();
     row.mField.mId = values[1]->int32_value();
@@ -0,0 +1,149 @@
+/*
+ * This file is part of ePipe
+ * Copyright (C) 2019, Logical Clocks AB. All rights reserved
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef STAGEDRECATTR_H
+#define STAGEDRECATTR_H
+#include "Utils.h"
+
+/*
+ * copy of the value an NdbRecAttr of an event holds, kept in storage
+ * owned by the caller and refilled for every event, or a view of a value
+ * held elsewhere such as a column of an NdbRecord row. Has the accessors of
+ * NdbRecAttr the tables read their rows with
+ */
+class StagedRecAttr {
+public:
+  StagedRecAttr() : mColumn(nullptr), mStorage(nullptr), mRef(nullptr),
+  mCapacity(0), mSize(0), mNull(-1) {
+  }
+
+  void bind(const NdbDictionary::Column* column, char* storage,
+      Uint32 capacity) {
+    mColumn = column;
+    mStorage = storage;
+    mRef = storage;
+    mCapacity = capacity;
+  }
+
+  void assign(const NdbRecAttr* attr) {
+    mNull = attr->isNULL();
+    mSize = mNull == 0 ? attr->get_size_in_bytes() : 0;
+    if (mSize > mCapacity) {
+      LOG_FATAL("value of " << mSize << " bytes does not fit the "
+          << mCapacity << " bytes staged for " << mColumn->getName());
+    }
+    std::memcpy(mStorage, attr->aRef(), mSize);
+    mRef = mStorage;
+  }
+
+  /*
+   * points at the value of the column laid out in an NdbRecord row, valid
+   * as long as the row is
+   */
+  void refer(const NdbDictionary::Column* column, const char* ref,
+      bool isNull) {
+    mColumn = column;
+    mRef = ref;
+    mNull = isNull ? 1 : 0;
+    const unsigned char* length = reinterpret_cast<const unsigned char*>(ref);
+    switch (column->getArrayType()) {
+      case NdbDictionary::Column::ArrayTypeShortVar:
+        mSize = 1 + length[0];
+        break;
+      case NdbDictionary::Column::ArrayTypeMediumVar:
+        mSize = 2 + length[0] + 256 * length[1];
+        break;
+      default:
+        mSize = column->getSizeInBytes();
+    }
+  }
+
+  /*
+   * points at the value an NdbRecAttr holds, valid as long as it is
+   */
+  void refer(const NdbRecAttr* attr) {
+    mColumn = attr->getColumn();
+    mRef = attr->aRef();
+    mNull = attr->isNULL();
+    mSize = mNull == 0 ? attr->get_size_in_bytes() : 0;
+  }
+
+  Int64 int64_value() const {
+    return get<Int64>();
+  }
+
+  Int32 int32_value() const {
+    return get<Int32>();
+  }
+
+  short short_value() const {
+    return get<short>();
+  }
+
+  Int8 int8_value() const {
+    return get<Int8>();
+  }
+
+  Uint64 u_64_value() const {
+    return get<Uint64>();
+  }
+
+  Uint32 u_32_value() const {
+    return get<Uint32>();
+  }
+
+  int isNULL() const {
+    return mNull;
+  }
+
+  const char* aRef() const {
+    return mRef;
+  }
+
+  Uint32 get_size_in_bytes() const {
+    return mSize;
+  }
+
+  const NdbDictionary::Column* getColumn() const {
+    return mColumn;
+  }
+
+  NdbDictionary::Column::Type getType() const {
+    return mColumn->getType();
+  }
+
+private:
+  const NdbDictionary::Column* mColumn;
+  char* mStorage;
+  const char* mRef;
+  Uint32 mCapacity;
+  Uint32 mSize;
+  int mNull;
+
+  // the staged storage and the NdbRecord columns are padded to at least 8
+  // bytes, so reading a wider type than the column stays inside them
+  template<typename T>
+  T get() const {
+    T value;
+    std::memcpy(&value, mRef, sizeof(T));
+    return value;
+  }
+};
+
+#endif /* STAGEDRECATTR_H */
@@ -50,6 +50,15 @@ public:
   }
 
   UserRow getRow(NdbRecAttr* values[]) {
+    return readRow(values);
+  }
+
+  UserRow getRow(StagedRecAttr* values[]) {
+    return readRow(values);
+  }
+
+  template<typename RecAttr>
+  UserRow readRow(RecAttr* values[]) {
     UserRow row;
     row.mId = values[0]->int32_value();
     row.mName = get_string(values[1]);
@@ -23,6 +23,11 @@
 #include "FsMutationsLogTable.h"
 #include "MetadataLogTable.h"
 
+// inode, namespace and name of an xattr, shared by all of its parts
+typedef PKKey<Int64, Int8, std::string> XAttrKey;
+// XAttrKey and the index of the part
+typedef PKKey<Int64, Int8, std::string, Int16> XAttrPartKey;
+
 struct XAttrRowPart{
   Int64 mInodeId;
   Int8 mNamespace;
@@ -44,16 +49,12 @@ struct XAttrRowPart{
     return stream.str();
   }
 
-  std::string getXAttrUniqueId(){
-    std::stringstream out;
-    out << mInodeId << "-" << std::to_string(mNamespace) << "-" << mName;
-    return out.str();
+  XAttrKey getXAttrKey() const {
+    return XAttrKey(mInodeId, mNamespace, mName);
   }
 
-  static std::string getXAttrUniqueId(FsMutationRow& row){
-    std::stringstream out;
-    out << row.mInodeId << "-" << std::to_string(row.getNamespace()) << "-" << row.getXAttrName();
-    return out.str();
+  static XAttrKey getXAttrKey(FsMutationRow& row){
+    return XAttrKey(row.mInodeId, row.getNamespace(), row.getXAttrName());
   }
 };
 
@@ -280,8 +281,8 @@ struct XAttrPK {
 };
 
 typedef std::vector<XAttrRow> XAttrVec;
-typedef boost::unordered_map<std::string, XAttrVec> XAttrMap;
-typedef boost::unordered_map<std::string, XAttrPartVec> XAttrPartMap;
+typedef boost::unordered_map<FsMutationRow::Key, XAttrVec> XAttrMap;
+typedef boost::unordered_map<XAttrKey, XAttrPartVec> XAttrPartMap;
 
 class XAttrTable : public DBTable<XAttrRowPart> {
 
@@ -297,6 +298,15 @@ public:
   }
 
   XAttrRowPart getRow(NdbRecAttr* values[]) {
+    return readRow(values);
+  }
+
+  XAttrRowPart getRow(StagedRecAttr* values[]) {
+    return readRow(values);
+  }
+
+  template<typename RecAttr>
+  XAttrRowPart readRow(RecAttr* values[]) {
     XAttrRowPart row;
     row.mInodeId = values[0]->int64_value();
     row.mNamespace = values[1]->int8_value();
@@ -308,35 +318,25 @@ public:
   }
 
   XAttrRow get(Ndb* connection, Int64 inodeId, Int8 ns, std::string name) {
-    AnyMap a;
-    a[0] = inodeId;
-    a[1] = ns;
-    a[2] = name;
-    a[3] = static_cast<Int16>(0);
-
-    XAttrRowPart firstPart = DBTable<XAttrRowPart>::doRead(connection, a);
+    XAttrRowPart firstPart = DBTable<XAttrRowPart>::doRead(connection,
+        XAttrPartKey(inodeId, ns, name, static_cast<Int16>(0)));
     LOG_DEBUG("XAttr get by parts " << firstPart.mNumParts);
     if(firstPart.mNumParts == 1){
       return XAttrRow(firstPart);
     }
 
-    AnyVec anyVec;
+    std::vector<XAttrPartKey> keys;
     for(Int16 index=1; index < firstPart.mNumParts; index++){
-        AnyMap pk;
-        pk[0] = inodeId;
-        pk[1] = ns;
-        pk[2] = name;
-        pk[3] = index;
-        anyVec.push_back(pk);
+      keys.push_back(XAttrPartKey(inodeId, ns, name, index));
     }
     
-    XAttrPartVec restOfParts = doRead(connection, anyVec);
+    XAttrPartVec restOfParts = doRead(connection, keys);
     LOG_DEBUG("XAttr batch read the rest of parts " << restOfParts.size());
     return XAttrRow(firstPart, restOfParts);
   }
 
   XAttrMap get(Ndb* connection, Fmq* data_batch) {
-    AnyVec anyVec;
+    std::vector<XAttrPartKey> keys;
     Fmq batchedMutations;
     Fmq addAllXattrs;
 
@@ -354,32 +354,27 @@ public:
 
       LOG_DEBUG("doRead batch for XAttr [ " + row.getXAttrName() + " ] to get its " << row.getNumParts() << " parts ");
       for(Int16 index=0; index < row.getNumParts(); index++){
-        AnyMap pk;
-        pk[0] = row.mInodeId;
-        pk[1] = row.getNamespace();
-        pk[2] = row.getXAttrName();
-        pk[3] = index;
-        anyVec.push_back(pk);
+        keys.push_back(XAttrPartKey(row.mInodeId, row.getNamespace(),
+            row.getXAttrName(), index));
       }
       batchedMutations.push_back(row);
     }
 
-    XAttrPartVec xattrsParts = doRead(connection, anyVec);
+    XAttrPartVec xattrsParts = doRead(connection, keys);
     XAttrMap results = combine(xattrsParts, batchedMutations);
 
     for(Fmq::iterator it = addAllXattrs.begin(); it != addAllXattrs.end();
     ++it){
       FsMutationRow mr = *it;
-      results[mr.getPKStr()] = getByInodeId(connection, mr.mInodeId);
+      results[mr.getKey()] = getByInodeId(connection, mr.mInodeId);
     }
 
     return results;
   }
 
   XAttrVec getByInodeId(Ndb* connection, Int64 inodeId){
-    AnyMap args;
-    args[0] = inodeId;
-    XAttrPartVec xattrsParts = doRead(connection, PRIMARY_INDEX, args, inodeId);
+    XAttrPartVec xattrsParts = doRead(connection, PRIMARY_INDEX,
+        PKKey<Int64>(inodeId), inodeId);
     return combine(xattrsParts);
   }
 
@@ -412,11 +407,11 @@ private:
     convert(partVec, xAttrsByName);
     XAttrMap results;
     for(auto& m : xAttrMutations){
-      std::string id = XAttrRowPart::getXAttrUniqueId(m);
+      XAttrKey id = XAttrRowPart::getXAttrKey(m);
       auto& vec = xAttrsByName[id];
       XAttrVec xvec;
       xvec.push_back(XAttrRow(vec));
-      results[m.getPKStr()] = xvec;
+      results[m.getKey()] = xvec;
     }
 
     return results;
@@ -424,7 +419,7 @@ private:
   
   void convert(XAttrPartVec& partVec, XAttrPartMap& xAttrsByName){
     for(auto& part : partVec){
-      std::string id = part.getXAttrUniqueId();
+      XAttrKey id = part.getXAttrKey();
       if(xAttrsByName.find(id) == xAttrsByName.end()){
         xAttrsByName[id] = XAttrPartVec();
       }
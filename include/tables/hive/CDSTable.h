@@ -33,7 +33,16 @@ public:
     addColumn("CD_ID");
   }
 
-  CDSRow getRow(NdbRecAttr *value[]) {
+  CDSRow getRow(NdbRecAttr* value[]) {
+    return readRow(value);
+  }
+
+  CDSRow getRow(StagedRecAttr* value[]) {
+    return readRow(value);
+  }
+
+  template<typename RecAttr>
+  CDSRow readRow(RecAttr* value[]) {
     CDSRow row;
     row.mCDSID = value[0]->int64_value();
     return row;
@@ -23,6 +23,9 @@
 #include "tables/DBWatchTable.h"
 
 struct IDXSRow{
+  // the hive tables are not recovered, no rows to tell apart
+  typedef PKKey<> Key;
+
   Int64 mINDEXID;
   Int64 mSDID;
 };
@@ -35,7 +38,16 @@ public:
     addWatchEvent(NdbDictionary::Event::TE_DELETE);
   }
 
-  IDXSRow getRow(NdbRecAttr *value[]){
+  IDXSRow getRow(NdbRecAttr* value[]) {
+    return readRow(value);
+  }
+
+  IDXSRow getRow(StagedRecAttr* value[]) {
+    return readRow(value);
+  }
+
+  template<typename RecAttr>
+  IDXSRow readRow(RecAttr* value[]) {
     IDXSRow row;
     row.mINDEXID = value[0]->int64_value();
     row.mSDID = value[1]->int64_value();
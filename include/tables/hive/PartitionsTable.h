@@ -23,6 +23,9 @@
 #include "tables/DBWatchTable.h"
 
 struct PartitionsRow{
+  // the hive tables are not recovered, no rows to tell apart
+  typedef PKKey<> Key;
+
   Int64 mPARTID;
   Int64 mSDID;
 };
@@ -35,7 +38,16 @@ public:
     addWatchEvent(NdbDictionary::Event::TE_DELETE);
   }
 
-  PartitionsRow getRow(NdbRecAttr *value[]){
+  PartitionsRow getRow(NdbRecAttr* value[]) {
+    return readRow(value);
+  }
+
+  PartitionsRow getRow(StagedRecAttr* value[]) {
+    return readRow(value);
+  }
+
+  template<typename RecAttr>
+  PartitionsRow readRow(RecAttr* value[]) {
     PartitionsRow row;
     row.mPARTID = value[0]->int64_value();
     row.mSDID = value[1]->int64_value();
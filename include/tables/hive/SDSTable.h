@@ -23,6 +23,9 @@
 #include "tables/DBWatchTable.h"
 
 struct SDSRow {
+  // the hive tables are not recovered, no rows to tell apart
+  typedef PKKey<> Key;
+
   Int64 mSDID;
   Int64 mCDID;
   Int64 mSERDEID;
@@ -39,7 +42,16 @@ public:
     addWatchEvent(NdbDictionary::Event::TE_DELETE);
   }
 
-  SDSRow getRow(NdbRecAttr* value[]){
+  SDSRow getRow(NdbRecAttr* value[]) {
+    return readRow(value);
+  }
+
+  SDSRow getRow(StagedRecAttr* value[]) {
+    return readRow(value);
+  }
+
+  template<typename RecAttr>
+  SDSRow readRow(RecAttr* value[]) {
     SDSRow row;
     row.mSDID = value[0]->int64_value();
     row.mCDID = value[1]->int64_value();
@@ -32,7 +32,16 @@ public:
     addColumn("SERDE_ID");
   }
 
-  SERDESRow getRow(NdbRecAttr* value[]){
+  SERDESRow getRow(NdbRecAttr* value[]) {
+    return readRow(value);
+  }
+
+  SERDESRow getRow(StagedRecAttr* value[]) {
+    return readRow(value);
+  }
+
+  template<typename RecAttr>
+  SERDESRow readRow(RecAttr* value[]) {
     SERDESRow row;
     row.mSERDEID = value[0]->int64_value();
     return row;
@@ -23,6 +23,9 @@
 #include "tables/DBWatchTable.h"
 
 struct SkewedLocRow{
+  // the hive tables are not recovered, no rows to tell apart
+  typedef PKKey<> Key;
+
   Int64 mSDID;
   Int64 mStringListID;
 };
@@ -35,7 +38,16 @@ public:
     addWatchEvent(NdbDictionary::Event::TE_DELETE);
   }
 
-  SkewedLocRow getRow(NdbRecAttr *value[]){
+  SkewedLocRow getRow(NdbRecAttr* value[]) {
+    return readRow(value);
+  }
+
+  SkewedLocRow getRow(StagedRecAttr* value[]) {
+    return readRow(value);
+  }
+
+  template<typename RecAttr>
+  SkewedLocRow readRow(RecAttr* value[]) {
     SkewedLocRow row;
     row.mSDID = value[0]->int64_value();
     row.mStringListID = value[1]->int64_value();
@@ -32,7 +32,16 @@ public:
     addColumn("STRING_LIST_ID");
   }
 
-  SkewedStringsRow getRow(NdbRecAttr *value[]) {
+  SkewedStringsRow getRow(NdbRecAttr* value[]) {
+    return readRow(value);
+  }
+
+  SkewedStringsRow getRow(StagedRecAttr* value[]) {
+    return readRow(value);
+  }
+
+  template<typename RecAttr>
+  SkewedStringsRow readRow(RecAttr* value[]) {
     SkewedStringsRow row;
     row.mStringListID = value[0]->int64_value();
     return row;
@@ -22,6 +22,9 @@
 #include "tables/DBWatchTable.h"
 
 struct SkewedValuesRow {
+  // the hive tables are not recovered, no rows to tell apart
+  typedef PKKey<> Key;
+
   Int64 mSDID;
   Int32 mIntegerIDX;
   Int64 mStringListID;
@@ -36,7 +39,16 @@ public:
     addWatchEvent(NdbDictionary::Event::TE_DELETE);
   }
 
-  SkewedValuesRow getRow(NdbRecAttr *value[]) {
+  SkewedValuesRow getRow(NdbRecAttr* value[]) {
+    return readRow(value);
+  }
+
+  SkewedValuesRow getRow(StagedRecAttr* value[]) {
+    return readRow(value);
+  }
+
+  template<typename RecAttr>
+  SkewedValuesRow readRow(RecAttr* value[]) {
     SkewedValuesRow row;
     row.mSDID = value[0]->int64_value();
     row.mIntegerIDX = value[1]->int32_value();
@@ -23,6 +23,9 @@
 #include "tables/DBWatchTable.h"
 
 struct TBLSRow {
+  // the hive tables are not recovered, no rows to tell apart
+  typedef PKKey<> Key;
+
   Int64 mTBLID;
   Int64 mSDID;
 };
@@ -38,7 +41,16 @@ public:
     addWatchEvent(NdbDictionary::Event::TE_DELETE);
   }
 
-  TBLSRow getRow(NdbRecAttr *value[]) {
+  TBLSRow getRow(NdbRecAttr* value[]) {
+    return readRow(value);
+  }
+
+  TBLSRow getRow(StagedRecAttr* value[]) {
+    return readRow(value);
+  }
+
+  template<typename RecAttr>
+  TBLSRow readRow(RecAttr* value[]) {
     TBLSRow row;
     row.mTBLID = value[0]->int64_value();
     row.mSDID = value[1]->int64_value();
@@ -19,7 +19,7 @@
 AppProvenanceElastic::AppProvenanceElastic(const HttpClientConfig elastic_client_config, std::string index,
         int time_to_wait_before_inserting, int bulk_size, const bool stats, SConn conn) : 
 ElasticSearchBase(elastic_client_config, time_to_wait_before_inserting,
-    bulk_size, stats, new MovingCountersBulkSet("app_prov")),
+    bulk_size, stats, "app_prov", new MovingCountersBulkSet("app_prov")),
 mIndex(index), mConn(conn) {
   mElasticBulkAddr = getElasticSearchBulkUrl(mIndex);
 }
@@ -39,6 +39,7 @@ void AppProvenanceElastic::process(std::vector<eBulk>* bulks) {
   ptime start_time = Utils::getCurrentTime();
   if (httpPostRequest(mElasticBulkAddr, batch).mSuccess) {
     AppProvenanceLogTable().removeLogs(mConn, logRHandlers);
+    EpochCheckpoint::acknowledgeLogs(logRHandlers);
     if (mStats) {
       mCounters->bulksProcessed(start_time, bulks);
     }
@@ -61,6 +62,7 @@ void AppProvenanceElastic::process(std::vector<eBulk>* bulks) {
 bool AppProvenanceElastic::bulkRequest(eEvent& event) {
   if (httpPostRequest(mElasticBulkAddr, event.getJSON()).mSuccess){
     event.getLogHandler()->removeLog(mConn);
+    EpochCheckpoint::acknowledgeLog(event.getLogHandler());
     return true;
   }
   return false;
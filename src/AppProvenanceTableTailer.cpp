@@ -17,7 +17,7 @@
 #include "AppProvenanceTableTailer.h"
 
 AppProvenanceTableTailer::AppProvenanceTableTailer(Ndb *ndb, Ndb* ndbRecovery, const int poll_maxTimeToWait, const Barrier barrier)
-: RCTableTailer(ndb, ndbRecovery, new AppProvenanceLogTable(), poll_maxTimeToWait, barrier) {
+: RCTableTailer(ndb, ndbRecovery, new AppProvenanceLogTable(), poll_maxTimeToWait, barrier, "app_prov") {
   mQueue = new AppCPRq();
   mCurrentPriorityQueue = new AppPRpq();
 }
@@ -51,13 +51,30 @@ void AppProvenanceTableTailer::barrierChanged() {
 AppProvenanceRow AppProvenanceTableTailer::consume() {
   AppProvenanceRow row;
   mQueue->wait_and_pop(row);
+  accountConsumed(row);
   LOG_TRACE("app prov - pop appid [" << row.mId << "] from queue \n" << row.to_string());
   return row;
 }
 
+std::vector<AppProvenanceRow> AppProvenanceTableTailer::consumeBatch(const int max_rows,
+    const ptime deadline) {
+  std::vector<AppProvenanceRow> rows;
+  mQueue->wait_and_pop_all(rows, max_rows, getTimeoutUS(deadline));
+  accountConsumed(rows);
+  LOG_TRACE("app prov - pop " << rows.size() << " rows from queue");
+  return rows;
+}
+
+unsigned int AppProvenanceTableTailer::getQueueDepth(int queue_id) {
+  return mQueue->size();
+}
+
 void AppProvenanceTableTailer::pushToQueue(AppPRpq *curr) {
   while (!curr->empty()) {
-    mQueue->push(curr->top());
+    // account the copy that is queued, its strings are sized to fit
+    AppProvenanceRow row = curr->top();
+    accountQueued(row);
+    mQueue->push(std::move(row));
     curr->pop();
   }
   delete curr;
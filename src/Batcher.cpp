@@ -20,8 +20,10 @@
 #include "Batcher.h"
 
 Batcher::Batcher(const int time_to_wait, const int batch_size)
-: mBatchSize(batch_size), mTimerProcessing(false), mTimeToWait(time_to_wait),
-mStarted(false), mFirstTimer(true), mScheduleShutdown(false), mShutdownTimer(false) {
+: mBatchSize(batch_size), mTimeToWait(time_to_wait),
+mStarted(false), mScheduleShutdown(false), mFlushRequested(false),
+mTimer(std::bind(&Batcher::timerFired, this)), mIdleLingerUs(-1),
+mMaxBatchFactor(1) {
   srand(time(NULL));
 }
 
@@ -36,10 +38,42 @@ void Batcher::start() {
   mStarted = true;
 }
 
+/*
+ * flush a pending batch as soon as the input goes idle, once its oldest item
+ * waited at least min_linger_us. The timer stays as the upper bound. Has to
+ * be called before start.
+ */
+void Batcher::enableIdleFlush(const int min_linger_us) {
+  mIdleLingerUs = min_linger_us;
+}
+
+bool Batcher::isIdleFlushEnabled() const {
+  return mIdleLingerUs >= 0;
+}
+
+int Batcher::getIdleLingerUS(const Int64 first_pending_us) const {
+  Int64 remaining = first_pending_us + mIdleLingerUs
+      - Utils::getMonotonicTimeInMicroseconds();
+  return remaining > 0 ? static_cast<int>(remaining) : 0;
+}
+
+/*
+ * grow the batches up to max_factor times the batch size as the backlog in
+ * front of the batcher fills up, so the readers get fewer and bigger round
+ * trips while we are behind. Has to be called before start.
+ */
+void Batcher::enableAdaptiveBatchSize(const int max_factor) {
+  mMaxBatchFactor = std::max(1, max_factor);
+}
+
+int Batcher::getAdaptiveBatchSize(const Uint32 backlog_percent) const {
+  Uint32 percent = std::min<Uint32>(backlog_percent, 100);
+  return mBatchSize + mBatchSize * (mMaxBatchFactor - 1) * percent / 100;
+}
+
 void Batcher::waitToFinish() {
   if (mStarted) {
     mThread.join();
-    mTimerThread.join();
   }
 }
 
@@ -51,44 +85,36 @@ void Batcher::shutdown(){
 }
 
 void Batcher::startTimer() {
-  LOG_DEBUG("start timer");
-  mTimerThread = boost::thread(&Batcher::timerThread, this);
-}
-
-void Batcher::timerThread() {
-  while (true) {
-    if(mShutdownTimer){
-      LOG_INFO("Shutdown batcher timer");
-      break;
-    }
-    mIOService.reset();
-    int timeout = mTimeToWait;
-    if (mFirstTimer) {
-      int baseTime = mTimeToWait / 4;
-      timeout = rand() % (mTimeToWait - baseTime) + baseTime;
-      mFirstTimer = false;
-      LOG_TRACE("fire the first timer after " << timeout << " msec");
-    }
-    boost::asio::deadline_timer timer(mIOService, boost::posix_time::milliseconds(timeout));
-    timer.async_wait(boost::bind(&Batcher::timerExpired, this, boost::asio::placeholders::error));
-    mIOService.run();
-  }
+  int baseTime = mTimeToWait / 4;
+  int timeout = rand() % (mTimeToWait - baseTime) + baseTime;
+  LOG_DEBUG("start timer, fire the first timer after " << timeout << " msec");
+  TimerWheel::getInstance().start(&mTimer, timeout, mTimeToWait);
 }
 
 void Batcher::resetTimer() {
-  mIOService.stop();
+  TimerWheel::getInstance().reset(&mTimer);
 }
 
-void Batcher::timerExpired(const boost::system::error_code& e) {
-  if (e) return;
-  mTimerProcessing = true;
-  processBatch();
-  mTimerProcessing = false;
+void Batcher::timerFired() {
+  timerExpired();
   if(mScheduleShutdown){
-    mShutdownTimer = true;
+    LOG_INFO("Shutdown batcher timer");
+    TimerWheel::getInstance().cancel(&mTimer);
   }
 }
 
-Batcher::~Batcher() {
+/*
+ * runs on the timer wheel thread which is shared by all batchers, so it only
+ * flags the flush and leaves it to the batcher thread
+ */
+void Batcher::timerExpired() {
+  mFlushRequested = true;
+}
+
+bool Batcher::takeFlushRequest() {
+  return mFlushRequested.exchange(false);
 }
 
+Batcher::~Batcher() {
+  TimerWheel::getInstance().cancel(&mTimer);
+}
@@ -21,9 +21,9 @@
 
 ElasticSearchBase::ElasticSearchBase(const HttpClientConfig
 elastic_client_config, int time_to_wait_before_inserting, int bulk_size,
-const bool statsEnabled, MovingCountersSet* const
+const bool statsEnabled, const std::string pipe, MovingCountersSet* const
 metricsCounters) : TimedRestBatcher(elastic_client_config,
-    time_to_wait_before_inserting, bulk_size),  mStats
+    time_to_wait_before_inserting, bulk_size, pipe),  mStats
     (statsEnabled), mCounters(metricsCounters), DEFAULT_TYPE("_doc") {
 }
 
@@ -108,6 +108,6 @@ ElasticSearchBase::~ElasticSearchBase() {
 }
 
 std::string ElasticSearchBase::getMetrics(){
-  return mCounters->getMetrics(mCurrentQueueSize,
+  return mCounters->getMetrics(getPendingEvents(),
       mElasticConnetionFailed, mTimeElasticConnectionFailed);
 }
\ No newline at end of file
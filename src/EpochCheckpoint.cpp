@@ -0,0 +1,210 @@
+/*
+ * This file is part of ePipe
+ * Copyright (C) 2019, Logical Clocks AB. All rights reserved
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "EpochCheckpoint.h"
+#include <fcntl.h>
+#include <cstdio>
+
+#define NO_HOLD std::numeric_limits<Uint64>::max()
+
+// filled once at startup, before the tailers and sinks start
+static boost::unordered_map<int, EpochCheckpoint*> sCheckpoints;
+
+EpochCheckpoint::EpochCheckpoint(const std::string dir, const std::string name)
+: mPath(dir + "/" + name + ".epoch"), mHandedOut(0), mHold(NO_HOLD),
+mLastPersistUs(0) {
+  mEpoch = load();
+  mHandedOut = mEpoch;
+}
+
+Uint64 EpochCheckpoint::getEpoch() {
+  std::lock_guard<std::mutex> lock(mLock);
+  return mEpoch;
+}
+
+/*
+ * an initial restart or a restored backup starts the epochs over, a
+ * checkpoint ahead of the cluster would skip every row until the cluster
+ * caught up with it, so it is dropped and the whole log table recovered
+ */
+void EpochCheckpoint::validate(Uint64 clusterEpoch) {
+  std::lock_guard<std::mutex> lock(mLock);
+  if (mEpoch < clusterEpoch) {
+    return;
+  }
+  LOG_WARN("Dropping epoch checkpoint " << mPath << " at " << mEpoch
+      << ", it is ahead of the cluster epoch " << clusterEpoch);
+  mEpoch = 0;
+  mHandedOut = 0;
+  persist(0);
+}
+
+void EpochCheckpoint::track(Uint64 epoch) {
+  std::lock_guard<std::mutex> lock(mLock);
+  mPending[epoch]++;
+}
+
+/*
+ * called after every poll of the tailer, also when nothing was handed out,
+ * so the acknowledgements held back by the interval are persisted even
+ * once the table went quiet
+ */
+void EpochCheckpoint::handedOut(Uint64 epoch) {
+  std::lock_guard<std::mutex> lock(mLock);
+  mHandedOut = std::max(mHandedOut, epoch);
+  advance();
+}
+
+void EpochCheckpoint::hold(Uint64 epoch) {
+  std::lock_guard<std::mutex> lock(mLock);
+  mHold = std::min(mHold, epoch);
+}
+
+void EpochCheckpoint::release() {
+  std::lock_guard<std::mutex> lock(mLock);
+  mHold = NO_HOLD;
+  advance();
+}
+
+void EpochCheckpoint::acknowledge(Uint64 epoch) {
+  std::lock_guard<std::mutex> lock(mLock);
+  auto it = mPending.find(epoch);
+  if (it == mPending.end()) {
+    return;
+  }
+  if (--it->second == 0) {
+    mPending.erase(it);
+    advance();
+  }
+}
+
+void EpochCheckpoint::flush() {
+  std::lock_guard<std::mutex> lock(mLock);
+  advance(true);
+}
+
+/*
+ * has to be called holding mLock
+ */
+void EpochCheckpoint::advance(bool force) {
+  Uint64 epoch = std::min(mHandedOut, mHold);
+  if (!mPending.empty()) {
+    epoch = std::min(epoch, mPending.begin()->first - 1);
+  }
+  Int64 now = Utils::getMonotonicTimeInMicroseconds();
+  if (epoch <= mEpoch || (!force
+      && now - mLastPersistUs < EPOCH_CHECKPOINT_INTERVAL_MS * 1000)) {
+    return;
+  }
+  mLastPersistUs = now;
+  if (persist(epoch)) {
+    mEpoch = epoch;
+  }
+}
+
+Uint64 EpochCheckpoint::load() {
+  FILE* file = fopen(mPath.c_str(), "r");
+  if (file == nullptr) {
+    LOG_INFO("No epoch checkpoint at " << mPath);
+    return 0;
+  }
+  unsigned long long epoch = 0;
+  if (fscanf(file, "%llu", &epoch) != 1) {
+    LOG_WARN("Ignoring unreadable epoch checkpoint at " << mPath);
+    epoch = 0;
+  }
+  fclose(file);
+  LOG_INFO("Epoch checkpoint at " << mPath << " is " << epoch);
+  return epoch;
+}
+
+/*
+ * written to a temporary file which replaces the checkpoint once synced,
+ * a crash leaves either the old or the new epoch behind
+ */
+bool EpochCheckpoint::persist(Uint64 epoch) {
+  std::string tmp = mPath + ".tmp";
+  std::string value = std::to_string(epoch) + "\n";
+  int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    LOG_ERROR("Failed to open " << tmp << " : " << strerror(errno));
+    return false;
+  }
+  bool written = write(fd, value.c_str(), value.length())
+      == static_cast<ssize_t>(value.length()) && fsync(fd) == 0;
+  close(fd);
+  if (!written || rename(tmp.c_str(), mPath.c_str()) != 0) {
+    LOG_ERROR("Failed to write epoch checkpoint " << mPath << " : "
+        << strerror(errno));
+    return false;
+  }
+
+  std::string dir = mPath.substr(0, mPath.find_last_of('/'));
+  int dirFd = open(dir.c_str(), O_RDONLY);
+  if (dirFd >= 0) {
+    fsync(dirFd);
+    close(dirFd);
+  }
+  LOG_DEBUG("Epoch checkpoint " << mPath << " advanced to " << epoch);
+  return true;
+}
+
+EpochCheckpoint* EpochCheckpoint::create(const std::string dir, LogType type,
+    const std::string name) {
+  EpochCheckpoint* checkpoint = new EpochCheckpoint(dir, name);
+  sCheckpoints[type] = checkpoint;
+  return checkpoint;
+}
+
+EpochCheckpoint* EpochCheckpoint::get(LogType type) {
+  auto it = sCheckpoints.find(type);
+  return it != sCheckpoints.end() ? it->second : nullptr;
+}
+
+void EpochCheckpoint::flushAll() {
+  for (auto& checkpoint : sCheckpoints) {
+    checkpoint.second->flush();
+  }
+}
+
+void EpochCheckpoint::acknowledgeLog(LogType type, Uint64 epoch) {
+  if (epoch == 0) {
+    return;
+  }
+  EpochCheckpoint* checkpoint = get(type);
+  if (checkpoint != nullptr) {
+    checkpoint->acknowledge(epoch);
+  }
+}
+
+void EpochCheckpoint::acknowledgeLog(const LogHandler* handler) {
+  if (handler != nullptr) {
+    acknowledgeLog(handler->getType(), handler->mEpoch);
+  }
+}
+
+void EpochCheckpoint::acknowledgeLogs(
+    const std::vector<const LogHandler*>& handlers) {
+  if (sCheckpoints.empty()) {
+    return;
+  }
+  for (auto handler : handlers) {
+    acknowledgeLog(handler);
+  }
+}
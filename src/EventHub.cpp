@@ -0,0 +1,99 @@
+/*
+ * This file is part of ePipe
+ * Copyright (C) 2019, Logical Clocks AB. All rights reserved
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "EventHub.h"
+#include "MemoryAccounting.h"
+
+EventHub::EventHub(Ndb* ndb, const int poll_maxTimeToWait,
+    const std::string name) : mNdb(ndb),
+mPollMaxTimeToWait(poll_maxTimeToWait), mName(name), mStarted(false) {
+}
+
+Ndb* EventHub::getNdb() {
+  return mNdb;
+}
+
+void EventHub::subscribe(NdbEventOperation* op, EventSubscriber* subscriber) {
+  op->setCustomData(subscriber);
+  mSubscribers.push_back(subscriber);
+}
+
+void EventHub::start() {
+  if (mStarted) {
+    return;
+  }
+  LOG_INFO("event hub " << mName << " polls for " << mSubscribers.size()
+      << " tables");
+  mThread = boost::thread(&EventHub::run, this);
+  mStarted = true;
+}
+
+void EventHub::waitToFinish() {
+  if (mStarted && mThread.joinable()) {
+    mThread.join();
+  }
+}
+
+void EventHub::run() {
+  try {
+    pollEvents();
+  } catch (boost::thread_interrupted&) {
+    LOG_ERROR("Thread is stopped");
+    return;
+  }
+}
+
+void EventHub::pollEvents() {
+  while (true) {
+    // leave the events in the ndb event buffer while the pipeline is over
+    // its memory budget
+    MemoryAccounting::getInstance().waitForBudget();
+    int r = mNdb->pollEvents2(mPollMaxTimeToWait);
+
+    for (auto subscriber : mSubscribers) {
+      subscriber->eventsPolled(mNdb);
+    }
+
+    if (r > 0) {
+      NdbEventOperation* op;
+      while ((op = mNdb->nextEvent2())) {
+        NdbDictionary::Event::TableEvent event = op->getEventType2();
+        if (event == NdbDictionary::Event::TE_OUT_OF_MEMORY
+            || event == NdbDictionary::Event::TE_INCONSISTENT) {
+          for (auto subscriber : mSubscribers) {
+            subscriber->eventReceived(op, event);
+          }
+          continue;
+        }
+        EventSubscriber* subscriber = static_cast<EventSubscriber*>(
+            op->getCustomData());
+        if (subscriber != nullptr) {
+          subscriber->eventReceived(op, event);
+        }
+      }
+    }
+
+    for (auto subscriber : mSubscribers) {
+      subscriber->pollDone(mNdb);
+    }
+  }
+}
+
+EventHub::~EventHub() {
+}
@@ -19,7 +19,7 @@
 
 FileProvenanceElastic::FileProvenanceElastic(const HttpClientConfig elastic_client_config, int time_to_wait_before_inserting,
     int bulk_size, const bool stats, SConn conn, int file_lru_cap, int xattr_lru_cap)
-    : ElasticSearchBase(elastic_client_config, time_to_wait_before_inserting, bulk_size, stats, new MovingCountersBulkSet("file_prov")),
+    : ElasticSearchBase(elastic_client_config, time_to_wait_before_inserting, bulk_size, stats, "file_prov", new MovingCountersBulkSet("file_prov")),
     mConn(conn), mFileProvTable(file_lru_cap, xattr_lru_cap) {}
 
 void FileProvenanceElastic::intProcessOneByOne(eBulk bulk) {
@@ -41,6 +41,7 @@ void FileProvenanceElastic::intProcessOneByOne(eBulk bulk) {
       }
       mFileProvTable.cleanLog(mConn, event.getLogHandler());
     }
+    EpochCheckpoint::acknowledgeLog(event.getLogHandler());
   }
 }
 
@@ -51,6 +52,7 @@ bool FileProvenanceElastic::intProcessBatch(std::string val, std::vector<eBulk>*
     if (httpPostRequest(mElasticBulkAddr, val).mSuccess) {
       //bulk success
       mFileProvTable.cleanLogs(mConn, cleanupHandlers);
+      EpochCheckpoint::acknowledgeLogs(cleanupHandlers);
       if (mStats && !bulks->empty()) {
         mCounters->bulksProcessed(start_time, bulks);
       }
@@ -62,6 +64,7 @@ bool FileProvenanceElastic::intProcessBatch(std::string val, std::vector<eBulk>*
     //maybe this was only nops for this index
     LOG_TRACE("file prov - elastic bulk has only nop events");
     mFileProvTable.cleanLogs(mConn, cleanupHandlers);
+    EpochCheckpoint::acknowledgeLogs(cleanupHandlers);
     if (mStats && !bulks->empty()) {
       mCounters->bulksProcessed(start_time, bulks);
     }
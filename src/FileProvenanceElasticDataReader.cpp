@@ -472,6 +472,7 @@ void FileProvenanceElasticDataReader::processAddedandDeleted(Pq* data_batch, eBu
     FileProvenanceRow row = *it;
     ProcessRowResult result = process_row(row);
     LogHandler* lh = mFileLogTable.getLogHandler(result.mLogPK, result.mCompanionPK);
+    lh->mEpoch = row.mEpoch;
     if (inodes.find(row.mInodeId) != inodes.end() || result.mProvOp == FileProvenanceConstantsRaw::Operation::OP_DELETE) {
       std::string elasticBulkOps = getElasticBulkOps(result.mElasticOps);
       bulk.push(lh, row.mEventCreationTime, elasticBulkOps);
@@ -483,19 +484,15 @@ void FileProvenanceElasticDataReader::processAddedandDeleted(Pq* data_batch, eBu
 }
 
 ULSet FileProvenanceElasticDataReader::getViewInodes(Pq* data_batch) {
-  AnyVec anyVec;
+  INodeKeyVec keys;
   for (Pq::iterator it = data_batch->begin(); it != data_batch->end(); ++it) {
     FileProvenanceRow row = *it;
     std::pair<FileProvenanceConstants::MLType, std::string> mlAux = FileProvenanceConstants::parseML(row);
     if(mlAux.first != FileProvenanceConstants::MLType::NONE) {
-      AnyMap pk;
-      pk[0] = row.mParentId;
-      pk[1] = row.mInodeName;
-      pk[2] = row.mPartitionId;
-      anyVec.push_back(pk);
+      keys.push_back(INodeKey(row.mParentId, row.mInodeName, row.mPartitionId));
     }
   }
-  INodeVec inodesAux = inodesTable.get(mNdbConnection, anyVec);
+  INodeVec inodesAux = inodesTable.get(mNdbConnection, keys);
   ULSet inodes;
   for (INodeVec::iterator it = inodesAux.begin(); it != inodesAux.end(); ++it) {
     INodeRow row = *it;
@@ -21,16 +21,16 @@
 
 FileProvenanceTableTailer::FileProvenanceTableTailer(Ndb *ndb, Ndb* ndbRecovery, const int poll_maxTimeToWait, const Barrier barrier,
         int prov_file_lru_cap, int prov_core_lru_cap)
-: RCTableTailer(ndb, ndbRecovery, new FileProvenanceLogTable(prov_file_lru_cap, prov_core_lru_cap), poll_maxTimeToWait, barrier) {
+: RCTableTailer(ndb, ndbRecovery, new FileProvenanceLogTable(prov_file_lru_cap, prov_core_lru_cap), poll_maxTimeToWait, barrier, "file_prov") {
   mQueue = new CPRq();
-  mCurrentPriorityQueue = new PRpq();
+  mCurrentEpochRows = new Pq();
 }
 
 void FileProvenanceTableTailer::handleEvent(NdbDictionary::Event::TableEvent eventType, FileProvenanceRow pre,
         FileProvenanceRow row) {
   mLock.lock();
-  mCurrentPriorityQueue->push(row);
-  int size = mCurrentPriorityQueue->size();
+  mCurrentEpochRows->push_back(row);
+  int size = mCurrentEpochRows->size();
   mLock.unlock();
 
   LOG_TRACE("file prov - push provenance log for [" << row.mInodeName << "] to queue[" << size << "], Op [" << row.mOperation << "]");
@@ -38,35 +38,56 @@ void FileProvenanceTableTailer::handleEvent(NdbDictionary::Event::TableEvent eve
 }
 
 void FileProvenanceTableTailer::barrierChanged() {
-  PRpq* pq = NULL;
+  Pq* rows = NULL;
   mLock.lock();
-  if (!mCurrentPriorityQueue->empty()) {
-    pq = mCurrentPriorityQueue;
-    mCurrentPriorityQueue = new PRpq();
+  if (!mCurrentEpochRows->empty()) {
+    rows = mCurrentEpochRows;
+    mCurrentEpochRows = new Pq();
   }
   mLock.unlock();
 
-  if (pq != NULL) {
-    LOG_TRACE("file prov --------------------------------------NEW BARRIER (" << pq->size() << " events )------------------- ");
-    pushToQueue(pq);
+  if (rows != NULL) {
+    LOG_TRACE("file prov --------------------------------------NEW BARRIER (" << rows->size() << " events )------------------- ");
+    pushToQueue(rows);
   }
 }
 
 FileProvenanceRow FileProvenanceTableTailer::consume() {
   FileProvenanceRow row;
   mQueue->wait_and_pop(row);
+  accountConsumed(row);
   LOG_TRACE("file prov - pop inode [" << row.mInodeId << "] from queue \n" << row.to_string());
   return row;
 }
 
-void FileProvenanceTableTailer::pushToQueue(PRpq *curr) {
-  while (!curr->empty()) {
-    mQueue->push(curr->top());
-    curr->pop();
-  }
+std::vector<FileProvenanceRow> FileProvenanceTableTailer::consumeBatch(const int max_rows,
+    const ptime deadline) {
+  std::vector<FileProvenanceRow> rows;
+  mQueue->wait_and_pop_all(rows, max_rows, getTimeoutUS(deadline));
+  accountConsumed(rows);
+  LOG_TRACE("file prov - pop " << rows.size() << " rows from queue");
+  return rows;
+}
+
+unsigned int FileProvenanceTableTailer::getQueueDepth(int queue_id) {
+  return mQueue->size();
+}
+
+void FileProvenanceTableTailer::pushToQueue(Pq *curr) {
+  accountQueued(*curr);
+  // the provenance order also depends on dataset operations, so it cannot be
+  // radix sorted on (inodeId, logicalTime). The comparator orders the greater
+  // row first, hence the swapped arguments.
+  FileProvenanceRowComparator comparator;
+  std::stable_sort(curr->begin(), curr->end(),
+      [&comparator](const FileProvenanceRow& r1, const FileProvenanceRow& r2) {
+    return comparator(r2, r1);
+  });
+  mQueue->push_all(*curr);
   delete curr;
 }
 
 FileProvenanceTableTailer::~FileProvenanceTableTailer() {
   delete mQueue;
+  delete mCurrentEpochRows;
 }
\ No newline at end of file
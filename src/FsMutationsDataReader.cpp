@@ -18,6 +18,7 @@
  */
 
 #include "FsMutationsDataReader.h"
+#include "EpochCheckpoint.h"
 #include "HopsworksOpsLogTailer.h"
 
 FsMutationsDataReader::FsMutationsDataReader(MConn connection, const bool hopsworks, const int lru_cap, const std::string search_index, const std::string featurestore_index)
@@ -111,7 +112,7 @@ void FsMutationsDataReader::createJSON(Fmq* pending, INodeMap& inodes,
         continue;
       }
 
-      std::string mutationpk = row.getPKStr();
+      FsMutationRow::Key mutationpk = row.getKey();
 
       if(xattrs.find(mutationpk) == xattrs.end()){
         LOG_DEBUG(" Data for xattr: " << row.getXAttrName() << ", "
@@ -160,6 +161,8 @@ void FsMutationsDataReader::createJSON(Fmq* pending, INodeMap& inodes,
       }
     }else{
       LOG_ERROR("Unknown fs operation " << row.to_string());
+      // no bulk carries it, so its epoch would hold back the checkpoint
+      EpochCheckpoint::acknowledgeLog(LogType::FSLOG, row.mEpoch);
     }
   }
 }
@@ -23,10 +23,13 @@
 //const static ptime EPOCH_TIME(boost::gregorian::date(1970,1,1)); 
 
 FsMutationsTableTailer::FsMutationsTableTailer(Ndb* ndb, Ndb* ndbRecovery,
-    const int poll_maxTimeToWait, const Barrier barrier) : RCTableTailer(ndb,
-        ndbRecovery, new FsMutationsLogTable(), poll_maxTimeToWait, barrier) {
-  mQueue = new CFSq();
-  mCurrentPriorityQueue = new FSpq();
+    const int poll_maxTimeToWait, const Barrier barrier, const int num_lanes)
+    : RCTableTailer(ndb, ndbRecovery, new FsMutationsLogTable(),
+        poll_maxTimeToWait, barrier, "fs") {
+  for (int i = 0; i < std::max(1, num_lanes); i++) {
+    mQueues.push_back(new CFSq());
+  }
+  mCurrentEpochRows = new FSv();
   //    mTimeTakenForEventsToArrive = 0;
   //    mNumOfEvents = 0;
   //    mPrintEveryNEvents = 0;
@@ -34,8 +37,8 @@ FsMutationsTableTailer::FsMutationsTableTailer(Ndb* ndb, Ndb* ndbRecovery,
 
 void FsMutationsTableTailer::handleEvent(NdbDictionary::Event::TableEvent eventType, FsMutationRow pre, FsMutationRow row) {
   mLock.lock();
-  mCurrentPriorityQueue->push(row);
-  int size = mCurrentPriorityQueue->size();
+  mCurrentEpochRows->push_back(row);
+  int size = mCurrentEpochRows->size();
   mLock.unlock();
 
   LOG_DEBUG("push inode [" << row.getINodeName() << "] to queue[" << size <<
@@ -53,37 +56,86 @@ void FsMutationsTableTailer::handleEvent(NdbDictionary::Event::TableEvent eventT
 }
 
 void FsMutationsTableTailer::barrierChanged() {
-  FSpq* pq = NULL;
+  FSv* rows = NULL;
   mLock.lock();
-  if (!mCurrentPriorityQueue->empty()) {
-    pq = mCurrentPriorityQueue;
-    mCurrentPriorityQueue = new FSpq();
+  if (!mCurrentEpochRows->empty()) {
+    rows = mCurrentEpochRows;
+    mCurrentEpochRows = new FSv();
   }
   mLock.unlock();
 
-  if (pq != NULL) {
-    LOG_TRACE("--------------------------------------NEW BARRIER (" << pq->size() << " events )------------------- ");
-    pushToQueue(pq);
+  if (rows != NULL) {
+    LOG_TRACE("--------------------------------------NEW BARRIER (" << rows->size() << " events )------------------- ");
+    pushToQueue(rows);
   }
 }
 
 FsMutationRow FsMutationsTableTailer::consume() {
+  return consumeMultiQueue(0);
+}
+
+std::vector<FsMutationRow> FsMutationsTableTailer::consumeBatch(const int max_rows,
+    const ptime deadline) {
+  return consumeMultiQueueBatch(0, max_rows, deadline);
+}
+
+FsMutationRow FsMutationsTableTailer::consumeMultiQueue(int queue_id) {
   FsMutationRow row;
-  mQueue->wait_and_pop(row);
-  LOG_DEBUG(" pop inode [" << row.mInodeId << "] from queue \n" << row.to_string());
+  mQueues[queue_id]->wait_and_pop(row);
+  accountConsumed(row);
+  LOG_DEBUG(" pop inode [" << row.mInodeId << "] from queue[" << queue_id
+      << "] \n" << row.to_string());
   return row;
 }
 
+std::vector<FsMutationRow> FsMutationsTableTailer::consumeMultiQueueBatch(
+    int queue_id, const int max_rows, const ptime deadline) {
+  std::vector<FsMutationRow> rows;
+  mQueues[queue_id]->wait_and_pop_all(rows, max_rows, getTimeoutUS(deadline));
+  accountConsumed(rows);
+  LOG_DEBUG(" pop " << rows.size() << " inodes from queue[" << queue_id << "]");
+  return rows;
+}
+
+unsigned int FsMutationsTableTailer::getQueueDepth(int queue_id) {
+  return mQueues[queue_id == SINGLE_QUEUE ? 0 : queue_id]->size();
+}
 
-void FsMutationsTableTailer::pushToQueue(FSpq* curr) {
-  while (!curr->empty()) {
-    mQueue->push(curr->top());
-    curr->pop();
+int FsMutationsTableTailer::getNumLanes() const {
+  return mQueues.size();
+}
+
+int FsMutationsTableTailer::getLane(const FsMutationRow& row) const {
+  return boost::hash<Int64>()(row.mDatasetINodeId) % mQueues.size();
+}
+
+void FsMutationsTableTailer::pushToQueue(FSv* curr) {
+  accountQueued(*curr);
+  radix_sort(*curr, FsMutationRowRadixKey());
+  if (mQueues.size() == 1) {
+    mQueues[0]->push_all(*curr);
+    delete curr;
+    return;
+  }
+
+  // splitting keeps the epoch order within every dataset
+  std::vector<FSv> lanes(mQueues.size());
+  for (auto& row : *curr) {
+    lanes[getLane(row)].push_back(std::move(row));
   }
   delete curr;
+
+  for (std::vector<FSv>::size_type i = 0; i < lanes.size(); i++) {
+    if (!lanes[i].empty()) {
+      mQueues[i]->push_all(lanes[i]);
+    }
+  }
 }
 
 FsMutationsTableTailer::~FsMutationsTableTailer() {
-  delete mQueue;
+  for (auto queue : mQueues) {
+    delete queue;
+  }
+  delete mCurrentEpochRows;
 }
 
@@ -40,6 +40,10 @@ void HopsworksOpsLogTailer::handleEvent(NdbDictionary::Event::TableEvent eventTy
   case Schema:
     handleSchema(arrivalTime, bulk, row);
     break;
+  default:
+    LOG_ERROR("Unsupported Operation on [" << OpsLogOnToStr(row.mOpOn) << "]");
+    EpochCheckpoint::acknowledgeLog(LogType::HOPSWORKSLOG, row.mEpoch);
+    break;
   }
   bulk.mEndProcessing = Utils::getCurrentTime();
   mElasticSearch->addData(bulk);
@@ -84,10 +88,12 @@ void HopsworksOpsLogTailer::handleSchema(ptime arrivalTime, eBulk &bulk, Hopswor
       bulk.push(mHopsworksLogTable.getLogRemovalHandler(logEvent), arrivalTime, json, eEvent::EventType::DeleteEvent, eEvent::AssetType::INode);
     } else {
       LOG_WARN("Schema/Template [" << logEvent.mOpId << "] does not exist");
+      EpochCheckpoint::acknowledgeLog(LogType::HOPSWORKSLOG, logEvent.mEpoch);
     }
   }else{
     LOG_ERROR("Unsupported Schema Operation [" << HopsworksOpTypeToStr(logEvent.mOpType)
                                                << "]. Only Delete is supported.");
+    EpochCheckpoint::acknowledgeLog(LogType::HOPSWORKSLOG, logEvent.mEpoch);
   }
 }
 
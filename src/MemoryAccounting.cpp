@@ -0,0 +1,116 @@
+/*
+ * This file is part of ePipe
+ * Copyright (C) 2019, Logical Clocks AB. All rights reserved
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "MemoryAccounting.h"
+
+MemoryAccount::MemoryAccount(const std::string pipe, const std::string stage)
+: mPipe(pipe), mStage(stage), mBytes(0) {
+}
+
+void MemoryAccount::add(const Uint64 bytes) {
+  mBytes += bytes;
+  MemoryAccounting::getInstance().mTotalBytes += bytes;
+}
+
+void MemoryAccount::release(const Uint64 bytes) {
+  mBytes -= bytes;
+  MemoryAccounting::getInstance().released(bytes);
+}
+
+Int64 MemoryAccount::getBytes() const {
+  return mBytes;
+}
+
+MemoryAccounting& MemoryAccounting::getInstance() {
+  // never destroyed, accounts are released by threads running at exit
+  static MemoryAccounting* instance = new MemoryAccounting();
+  return *instance;
+}
+
+MemoryAccounting::MemoryAccounting() : mTotalBytes(0), mBudget(0),
+mResumeBytes(0), mThrottledUs(0), mWaiters(0) {
+}
+
+MemoryAccount* MemoryAccounting::getAccount(const std::string pipe,
+    const std::string stage) {
+  boost::mutex::scoped_lock lock(mLock);
+  for (auto account : mAccounts) {
+    if (account->mPipe == pipe && account->mStage == stage) {
+      return account;
+    }
+  }
+  MemoryAccount* account = new MemoryAccount(pipe, stage);
+  mAccounts.push_back(account);
+  return account;
+}
+
+void MemoryAccounting::setBudget(const Uint64 bytes) {
+  mResumeBytes = bytes / 100 * MEMORY_BUDGET_RESUME_PERCENT;
+  mBudget = bytes;
+}
+
+/*
+ * the waiters are counted before they check the total, so a release either
+ * sees them and wakes them up or they see the released bytes
+ */
+void MemoryAccounting::released(const Uint64 bytes) {
+  Int64 total = mTotalBytes -= bytes;
+  if (mWaiters > 0 && total <= mResumeBytes) {
+    boost::mutex::scoped_lock lock(mWaitLock);
+    mResumed.notify_all();
+  }
+}
+
+void MemoryAccounting::waitForBudget() {
+  Uint64 budget = mBudget;
+  if (budget == 0 || mTotalBytes < static_cast<Int64>(budget)) {
+    return;
+  }
+
+  LOG_WARN("memory budget of " << budget << " bytes exceeded ["
+      << mTotalBytes << "], throttling");
+  Int64 startUs = Utils::getMonotonicTimeInMicroseconds();
+  mWaiters++;
+  {
+    boost::mutex::scoped_lock lock(mWaitLock);
+    while (mTotalBytes > mResumeBytes) {
+      mResumed.wait(lock);
+    }
+  }
+  mWaiters--;
+  mThrottledUs += Utils::getMonotonicTimeInMicroseconds() - startUs;
+  LOG_INFO("memory back to " << mTotalBytes << " bytes, resuming");
+}
+
+Int64 MemoryAccounting::getTotalBytes() const {
+  return mTotalBytes;
+}
+
+std::string MemoryAccounting::getMetrics() {
+  std::stringstream out;
+  boost::mutex::scoped_lock lock(mLock);
+  for (auto account : mAccounts) {
+    out << "epipe_memory_bytes{pipe=\"" << account->mPipe << "\",stage=\""
+        << account->mStage << "\"} " << account->getBytes() << std::endl;
+  }
+  out << "epipe_memory_total_bytes " << mTotalBytes << std::endl;
+  out << "epipe_memory_budget_bytes " << mBudget << std::endl;
+  out << "epipe_memory_throttled_seconds " << mThrottledUs / 1000000.0 << std::endl;
+  return out.str();
+}
@@ -22,24 +22,57 @@
 MetadataLogTailer::MetadataLogTailer(Ndb* ndb, Ndb* ndbRecovery, const int
 poll_maxTimeToWait, const Barrier barrier)
 : RCTableTailer<MetadataLogEntry> (ndb, ndbRecovery,new MetadataLogTable(),
-    poll_maxTimeToWait, barrier) {
+    poll_maxTimeToWait, barrier, "schemabased") {
   mSchemaBasedQueue = new CMetaQ();
+  mCurrentBatch = new MetaQ();
 }
 
 void MetadataLogTailer::handleEvent(NdbDictionary::Event::TableEvent eventType, MetadataLogEntry pre, MetadataLogEntry row) {
-
-  mSchemaBasedQueue->push(row);
+  mLock.lock();
+  mCurrentBatch->push_back(row);
+  mLock.unlock();
   LOG_DEBUG(" push metalog " << row.mMetaPK.getPKStr() << " to queue, Op [" <<
   HopsworksOpTypeToStr(row.mMetaOpType) << "]");
 }
 
+void MetadataLogTailer::barrierChanged() {
+  MetaQ* batch = NULL;
+  mLock.lock();
+  if (!mCurrentBatch->empty()) {
+    batch = mCurrentBatch;
+    mCurrentBatch = new MetaQ();
+  }
+  mLock.unlock();
+
+  if (batch != NULL) {
+    accountQueued(*batch);
+    mSchemaBasedQueue->push_all(*batch);
+    delete batch;
+  }
+}
+
 MetadataLogEntry MetadataLogTailer::consume() {
   MetadataLogEntry res;
   mSchemaBasedQueue->wait_and_pop(res);
+  accountConsumed(res);
   LOG_TRACE(" pop metalog [" << res.mId << "] \n" << res.to_string());
   return res;
 }
 
+std::vector<MetadataLogEntry> MetadataLogTailer::consumeBatch(const int max_rows,
+    const ptime deadline) {
+  std::vector<MetadataLogEntry> rows;
+  mSchemaBasedQueue->wait_and_pop_all(rows, max_rows, getTimeoutUS(deadline));
+  accountConsumed(rows);
+  LOG_TRACE(" pop " << rows.size() << " metalogs from queue");
+  return rows;
+}
+
+unsigned int MetadataLogTailer::getQueueDepth(int queue_id) {
+  return mSchemaBasedQueue->size();
+}
+
 MetadataLogTailer::~MetadataLogTailer() {
   delete mSchemaBasedQueue;
+  delete mCurrentBatch;
 }
\ No newline at end of file
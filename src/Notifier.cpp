@@ -29,7 +29,15 @@ Notifier::Notifier(const char* connection_string, const char* database_name,
         const int elastic_batch_size, const int elastic_issue_time,
         const int lru_cap, const int prov_file_lru_cap, const int prov_core_lru_cap, const bool recovery,
         const bool stats, Barrier barrier, const bool hiveCleaner, const
-        std::string metricsServer)
+        std::string metricsServer, const bool work_stealing,
+        const int fs_mutations_lanes, const int idle_flush_linger_us,
+        const Watermarks reader_watermarks, const Watermarks elastic_watermarks,
+        const int eventbuf_max_alloc_mb, const int memory_budget_mb,
+        const int tailer_decode_workers, const int eventbuf_free_percent,
+        const int adaptive_batch_factor, const bool gap_recovery,
+        const int event_hubs, const int recovery_batch_rows,
+        const int recovery_scan_parallelism, const int recovery_scan_batch,
+        const std::string checkpoint_dir)
 : ClusterConnectionBase(connection_string, database_name, meta_database_name, hive_meta_database_name), 
     mMutationsTU(mutations_tu), mSchemabasedTU(schemabased_tu),
     mFileProvenanceTU(elastic_provenance_tu), mAppProvenanceTU(elastic_provenance_tu), 
@@ -38,7 +46,20 @@ Notifier::Notifier(const char* connection_string, const char* database_name,
     mElasticAppProvenanceIndex(elastic_app_provenance_index),
     mElasticBatchsize(elastic_batch_size), mElasticIssueTime(elastic_issue_time),
     mLRUCap(lru_cap), mProvFileLRUCap(prov_file_lru_cap), mProvCoreLRUCap(prov_core_lru_cap),
-    mRecovery(recovery), mStats(stats), mBarrier(barrier), mHiveCleaner(hiveCleaner), mMetricsServer(metricsServer) {
+    mRecovery(recovery), mStats(stats), mBarrier(barrier), mHiveCleaner(hiveCleaner), mMetricsServer(metricsServer),
+    mWorkStealing(work_stealing), mFsMutationsLanes(std::max(1, fs_mutations_lanes)),
+    mIdleFlushLingerUs(idle_flush_linger_us), mReaderWatermarks(reader_watermarks),
+    mElasticWatermarks(elastic_watermarks), mEventBufMaxAllocMB(eventbuf_max_alloc_mb),
+    mMemoryBudgetMB(memory_budget_mb),
+    mTailerDecodeWorkers(tailer_decode_workers),
+    mEventBufFreePercent(eventbuf_free_percent),
+    mAdaptiveBatchFactor(adaptive_batch_factor),
+    mGapRecovery(gap_recovery),
+    mEventHubs(event_hubs),
+    mRecoveryBatchRows(recovery_batch_rows),
+    mRecoveryScanParallelism(recovery_scan_parallelism),
+    mRecoveryScanBatch(recovery_scan_batch),
+    mCheckpointDir(checkpoint_dir) {
   setup();
 }
 
@@ -47,13 +68,15 @@ void Notifier::start() {
   ptime t1 = getCurrentTime();
 
   if (mMutationsTU.isEnabled()) {
-    mFsMutationsDataReaders->start();
-    mFsMutationsBatcher->start();
+    for (int lane = 0; lane < mFsMutationsLanes; lane++) {
+      mFsMutationsDataReaders[lane]->start(mWorkStealing);
+      mFsMutationsBatchers[lane]->start();
+    }
     mFsMutationsTableTailer->start();
   }
 
   if (mSchemabasedTU.isEnabled()) {
-    mSchemabasedMetadataReaders->start();
+    mSchemabasedMetadataReaders->start(mWorkStealing);
     mSchemabasedMetadataBatcher->start();
     mMetadataLogTailer->start();
   }
@@ -69,13 +92,13 @@ void Notifier::start() {
 
   if (mFileProvenanceTU.isEnabled()) {
     mFileProvenanceElastic->start();
-    mFileProvenanceElasticDataReaders->start();
+    mFileProvenanceElasticDataReaders->start(mWorkStealing);
     mFileProvenanceBatcher->start();
     mFileProvenanceTableTailer->start();
   }
   if(mAppProvenanceTU.isEnabled()) {
     mAppProvenanceElastic->start();
-    mAppProvenanceElasticDataReaders->start();
+    mAppProvenanceElasticDataReaders->start(mWorkStealing);
     mAppProvenanceBatcher->start();
     mAppProvenanceTableTailer->start();
   }
@@ -89,6 +112,13 @@ void Notifier::start() {
     mSkewedValuesTailer->start();
   }
 
+  // shared hubs poll once all their tables subscribed
+  for (auto& hubs : mEventHubsByDatabase) {
+    for (auto hub : hubs.second) {
+      hub->start();
+    }
+  }
+
   ptime t2 = getCurrentTime();
   LOG_INFO("ePipe started in " << getTimeDiffInMilliseconds(t1, t2) << " msec");
 
@@ -97,7 +127,9 @@ void Notifier::start() {
   }
 
   if (mMutationsTU.isEnabled()) {
-    mFsMutationsBatcher->waitToFinish();
+    for (auto batcher : mFsMutationsBatchers) {
+      batcher->waitToFinish();
+    }
     mFsMutationsTableTailer->waitToFinish();
   }
 
@@ -134,9 +166,20 @@ void Notifier::start() {
     mSkewedLocTailer->waitToFinish();
     mSkewedValuesTailer->waitToFinish();
   }
+
+  for (auto& hubs : mEventHubsByDatabase) {
+    for (auto hub : hubs.second) {
+      hub->waitToFinish();
+    }
+  }
 }
 
 void Notifier::setup() {
+  if (mMemoryBudgetMB > 0) {
+    MemoryAccounting::getInstance().setBudget(
+        static_cast<Uint64>(mMemoryBudgetMB) * 1024 * 1024);
+  }
+
   if (mMutationsTU.isEnabled() || mSchemabasedTU.isEnabled() ||
   mHopsworksEnabled) {
     MConn ndb_connections_elastic;
@@ -145,37 +188,66 @@ void Notifier::setup() {
 
     mProjectsElasticSearch = new ProjectsElasticSearch(mElasticClientConfig,
             mElasticIssueTime, mElasticBatchsize, mStats, ndb_connections_elastic);
+    mProjectsElasticSearch->enableIdleFlush(mIdleFlushLingerUs);
+    mProjectsElasticSearch->setWatermarks(mElasticWatermarks);
   }
 
 
   if (mMutationsTU.isEnabled()) {
-    Ndb* mutations_tailer_connection = create_ndb_connection(mDatabaseName);
+    Ndb* mutations_tailer_connection = create_tailer_ndb_connection(mDatabaseName);
     Ndb* mutations_tailer_recovery_connection = mRecovery ?
         create_ndb_connection(mDatabaseName) : nullptr;
 
     mFsMutationsTableTailer = new FsMutationsTableTailer(mutations_tailer_connection,
-        mutations_tailer_recovery_connection, mPollMaxTimeToWait, mBarrier);
-
-    MConn* mutations_connections = new MConn[mMutationsTU.mNumReaders];
-    for (int i = 0; i < mMutationsTU.mNumReaders; i++) {
-      mutations_connections[i].inodeConnection = create_ndb_connection(mDatabaseName);
-      mutations_connections[i].metadataConnection = create_ndb_connection(mMetaDatabaseName);
+        mutations_tailer_recovery_connection, mPollMaxTimeToWait, mBarrier,
+        mFsMutationsLanes);
+    mFsMutationsTableTailer->setDecodeWorkers(mTailerDecodeWorkers);
+    mFsMutationsTableTailer->setRecoveryBatchRows(mRecoveryBatchRows);
+    mFsMutationsTableTailer->setRecoveryScan(create_recovery_scan_connections(mDatabaseName),
+        mRecoveryScanBatch);
+    mFsMutationsTableTailer->setEventHub(get_event_hub(mDatabaseName));
+    mFsMutationsTableTailer->setCheckpoint(create_checkpoint(LogType::FSLOG, "fs_mutations"));
+    if (mGapRecovery) {
+      mFsMutationsTableTailer->enableGapRecovery(create_ndb_connection(mDatabaseName));
     }
 
-    mFsMutationsDataReaders = new FsMutationsDataReaders(mutations_connections, mMutationsTU.mNumReaders,
-            mHopsworksEnabled, mProjectsElasticSearch, mLRUCap, mElasticSearchIndex, mElasticFeaturestoreIndex);
-    mFsMutationsBatcher = new FsMutationsBatcher(mFsMutationsTableTailer, mFsMutationsDataReaders,
-            mMutationsTU.mWaitTime, mMutationsTU.mBatchSize);
+    for (int lane = 0; lane < mFsMutationsLanes; lane++) {
+      MConn* mutations_connections = new MConn[mMutationsTU.mNumReaders];
+      for (int i = 0; i < mMutationsTU.mNumReaders; i++) {
+        mutations_connections[i].inodeConnection = create_ndb_connection(mDatabaseName);
+        mutations_connections[i].metadataConnection = create_ndb_connection(mMetaDatabaseName);
+      }
+
+      // a single lane keeps the plain shared queue and unlabeled metrics
+      int queue_id = mFsMutationsLanes == 1 ? SINGLE_QUEUE : lane;
+      mFsMutationsDataReaders.push_back(new FsMutationsDataReaders(mutations_connections,
+          mMutationsTU.mNumReaders, mHopsworksEnabled, mProjectsElasticSearch, mLRUCap,
+          mElasticSearchIndex, mElasticFeaturestoreIndex, queue_id));
+      mFsMutationsDataReaders[lane]->setWatermarks(mReaderWatermarks);
+      mFsMutationsBatchers.push_back(new FsMutationsBatcher(mFsMutationsTableTailer,
+          mFsMutationsDataReaders[lane], mMutationsTU.mWaitTime, mMutationsTU.mBatchSize,
+          queue_id));
+      mFsMutationsBatchers[lane]->enableIdleFlush(mIdleFlushLingerUs);
+      mFsMutationsBatchers[lane]->enableAdaptiveBatchSize(mAdaptiveBatchFactor);
+    }
   }
 
   if (mSchemabasedTU.isEnabled()) {
 
-    Ndb* metadata_tailer_connection = create_ndb_connection(mMetaDatabaseName);
+    Ndb* metadata_tailer_connection = create_tailer_ndb_connection(mMetaDatabaseName);
     Ndb* metadata_tailer_recovery_connection = mRecovery ? create_ndb_connection
         (mMetaDatabaseName) : nullptr;
     mMetadataLogTailer = new MetadataLogTailer(metadata_tailer_connection,
         metadata_tailer_recovery_connection,
         mPollMaxTimeToWait, mBarrier);
+    mMetadataLogTailer->setDecodeWorkers(mTailerDecodeWorkers);
+    mMetadataLogTailer->setRecoveryBatchRows(mRecoveryBatchRows);
+    // recovered sorted by the primary key, so never in parallel
+    mMetadataLogTailer->setRecoveryScan(std::vector<Ndb*>(), mRecoveryScanBatch);
+    mMetadataLogTailer->setEventHub(get_event_hub(mMetaDatabaseName));
+    if (mGapRecovery) {
+      mMetadataLogTailer->enableGapRecovery(create_ndb_connection(mMetaDatabaseName));
+    }
 
     MConn* metadata_connections = new MConn[mSchemabasedTU.mNumReaders];
     for (int i = 0; i < mSchemabasedTU.mNumReaders; i++) {
@@ -185,17 +257,28 @@ void Notifier::setup() {
 
     mSchemabasedMetadataReaders = new SchemabasedMetadataReaders(metadata_connections, mSchemabasedTU.mNumReaders,
             mHopsworksEnabled, mProjectsElasticSearch, mLRUCap);
+    mSchemabasedMetadataReaders->setWatermarks(mReaderWatermarks);
     mSchemabasedMetadataBatcher = new SchemabasedMetadataBatcher(mMetadataLogTailer, mSchemabasedMetadataReaders,
             mSchemabasedTU.mWaitTime, mSchemabasedTU.mBatchSize);
+    mSchemabasedMetadataBatcher->enableIdleFlush(mIdleFlushLingerUs);
+    mSchemabasedMetadataBatcher->enableAdaptiveBatchSize(mAdaptiveBatchFactor);
   }
 
   if (mHopsworksEnabled) {
-    Ndb* ops_log_tailer_connection = create_ndb_connection(mMetaDatabaseName);
+    Ndb* ops_log_tailer_connection = create_tailer_ndb_connection(mMetaDatabaseName);
     Ndb* ops_log_tailer_recovery_connection = mRecovery ? create_ndb_connection
         (mMetaDatabaseName) : nullptr;
     mhopsworksOpsLogTailer = new HopsworksOpsLogTailer(ops_log_tailer_connection,
         ops_log_tailer_recovery_connection, mPollMaxTimeToWait, mBarrier,
             mProjectsElasticSearch, mLRUCap, mElasticSearchIndex);
+    mhopsworksOpsLogTailer->setEventHub(get_event_hub(mMetaDatabaseName));
+    mhopsworksOpsLogTailer->setCheckpoint(create_checkpoint(LogType::HOPSWORKSLOG, "hopsworks_ops"));
+    mhopsworksOpsLogTailer->setRecoveryBatchRows(mRecoveryBatchRows);
+    // recovered sorted by the primary key, so never in parallel
+    mhopsworksOpsLogTailer->setRecoveryScan(std::vector<Ndb*>(), mRecoveryScanBatch);
+    if (mGapRecovery) {
+      mhopsworksOpsLogTailer->enableGapRecovery(create_ndb_connection(mMetaDatabaseName));
+    }
   }
 
   if (mFileProvenanceTU.isEnabled()) {
@@ -203,12 +286,23 @@ void Notifier::setup() {
     Ndb* ndb_elastic_file_provenance_conn = create_ndb_connection(mDatabaseName);
     mFileProvenanceElastic = new FileProvenanceElastic(mElasticClientConfig,
       mElasticIssueTime, mElasticBatchsize, mStats, ndb_elastic_file_provenance_conn, mProvFileLRUCap, mProvCoreLRUCap);
+    mFileProvenanceElastic->enableIdleFlush(mIdleFlushLingerUs);
+    mFileProvenanceElastic->setWatermarks(mElasticWatermarks);
 
-    Ndb* elastic_file_provenance_tailer_connection = create_ndb_connection(mDatabaseName);
+    Ndb* elastic_file_provenance_tailer_connection = create_tailer_ndb_connection(mDatabaseName);
     Ndb* elastic_file_provenance_tailer_recovery_connection = mRecovery ? create_ndb_connection(mDatabaseName) : nullptr;
     mFileProvenanceTableTailer = new FileProvenanceTableTailer(
         elastic_file_provenance_tailer_connection, elastic_file_provenance_tailer_recovery_connection,
         mPollMaxTimeToWait, mBarrier, mProvFileLRUCap, mProvCoreLRUCap);
+    mFileProvenanceTableTailer->setDecodeWorkers(mTailerDecodeWorkers);
+    mFileProvenanceTableTailer->setRecoveryBatchRows(mRecoveryBatchRows);
+    mFileProvenanceTableTailer->setRecoveryScan(create_recovery_scan_connections(mDatabaseName),
+        mRecoveryScanBatch);
+    mFileProvenanceTableTailer->setEventHub(get_event_hub(mDatabaseName));
+    mFileProvenanceTableTailer->setCheckpoint(create_checkpoint(LogType::PROVFILELOG, "file_provenance"));
+    if (mGapRecovery) {
+      mFileProvenanceTableTailer->enableGapRecovery(create_ndb_connection(mDatabaseName));
+    }
 
     SConn* file_prov_hops_connections = new SConn[mFileProvenanceTU.mNumReaders];
     for (int i = 0; i < mFileProvenanceTU.mNumReaders; i++) {
@@ -216,21 +310,35 @@ void Notifier::setup() {
     }
     mFileProvenanceElasticDataReaders = new FileProvenanceElasticDataReaders(file_prov_hops_connections,
       mFileProvenanceTU.mNumReaders, mHopsworksEnabled, mFileProvenanceElastic, mProvFileLRUCap, mProvCoreLRUCap, mLRUCap);
+    mFileProvenanceElasticDataReaders->setWatermarks(mReaderWatermarks);
     mFileProvenanceBatcher = new RCBatcher<FileProvenanceRow, SConn>(
       mFileProvenanceTableTailer, mFileProvenanceElasticDataReaders,
       mFileProvenanceTU.mWaitTime, mFileProvenanceTU.mBatchSize);
+    mFileProvenanceBatcher->enableIdleFlush(mIdleFlushLingerUs);
+    mFileProvenanceBatcher->enableAdaptiveBatchSize(mAdaptiveBatchFactor);
   }
   if (mAppProvenanceTU.isEnabled()) {
     //app
     Ndb* ndb_elastic_app_provenance_conn = create_ndb_connection(mDatabaseName);
     mAppProvenanceElastic = new AppProvenanceElastic(mElasticClientConfig, mElasticAppProvenanceIndex,
       mElasticIssueTime, mElasticBatchsize, mStats, ndb_elastic_app_provenance_conn);
+    mAppProvenanceElastic->enableIdleFlush(mIdleFlushLingerUs);
+    mAppProvenanceElastic->setWatermarks(mElasticWatermarks);
 
-    Ndb* elastic_app_provenance_tailer_connection = create_ndb_connection(mDatabaseName);
+    Ndb* elastic_app_provenance_tailer_connection = create_tailer_ndb_connection(mDatabaseName);
     Ndb* elastic_app_provenance_tailer_recovery_connection = mRecovery ? create_ndb_connection(mDatabaseName) : nullptr;
     mAppProvenanceTableTailer = new AppProvenanceTableTailer(
         elastic_app_provenance_tailer_connection, elastic_app_provenance_tailer_recovery_connection,
         mPollMaxTimeToWait, mBarrier);
+    mAppProvenanceTableTailer->setDecodeWorkers(mTailerDecodeWorkers);
+    mAppProvenanceTableTailer->setRecoveryBatchRows(mRecoveryBatchRows);
+    mAppProvenanceTableTailer->setRecoveryScan(create_recovery_scan_connections(mDatabaseName),
+        mRecoveryScanBatch);
+    mAppProvenanceTableTailer->setEventHub(get_event_hub(mDatabaseName));
+    mAppProvenanceTableTailer->setCheckpoint(create_checkpoint(LogType::PROVAPPLOG, "app_provenance"));
+    if (mGapRecovery) {
+      mAppProvenanceTableTailer->enableGapRecovery(create_ndb_connection(mDatabaseName));
+    }
 
     SConn* elastic_app_provenance_connections = new SConn[mAppProvenanceTU.mNumReaders];
     for (int i = 0; i < mAppProvenanceTU.mNumReaders; i++) {
@@ -238,58 +346,156 @@ void Notifier::setup() {
     }
     mAppProvenanceElasticDataReaders = new AppProvenanceElasticDataReaders(elastic_app_provenance_connections, 
       mAppProvenanceTU.mNumReaders, mHopsworksEnabled, mAppProvenanceElastic);
+    mAppProvenanceElasticDataReaders->setWatermarks(mReaderWatermarks);
     mAppProvenanceBatcher = new RCBatcher<AppProvenanceRow, SConn>(
       mAppProvenanceTableTailer, mAppProvenanceElasticDataReaders,
       mAppProvenanceTU.mWaitTime, mAppProvenanceTU.mBatchSize);
+    mAppProvenanceBatcher->enableIdleFlush(mIdleFlushLingerUs);
+    mAppProvenanceBatcher->enableAdaptiveBatchSize(mAdaptiveBatchFactor);
   }
 
 
   if(mHiveCleaner) {
-    Ndb *tbls_tailer_connection = create_ndb_connection(mHiveMetaDatabaseName);
+    Ndb *tbls_tailer_connection = create_tailer_ndb_connection(mHiveMetaDatabaseName);
     mTblsTailer = new TBLSTailer(tbls_tailer_connection, mPollMaxTimeToWait,
         mBarrier);
+    mTblsTailer->setEventHub(get_event_hub(mHiveMetaDatabaseName));
 
-    Ndb *sds_tailer_connection = create_ndb_connection(mHiveMetaDatabaseName);
+    Ndb *sds_tailer_connection = create_tailer_ndb_connection(mHiveMetaDatabaseName);
     mSDSTailer = new SDSTailer(sds_tailer_connection, mPollMaxTimeToWait,
         mBarrier);
+    mSDSTailer->setEventHub(get_event_hub(mHiveMetaDatabaseName));
 
-    Ndb *part_tailer_connection = create_ndb_connection(mHiveMetaDatabaseName);
+    Ndb *part_tailer_connection = create_tailer_ndb_connection(mHiveMetaDatabaseName);
     mPARTTailer = new PARTTailer(part_tailer_connection, mPollMaxTimeToWait,
                                mBarrier);
+    mPARTTailer->setEventHub(get_event_hub(mHiveMetaDatabaseName));
 
-    Ndb *idxs_tailer_connection = create_ndb_connection(mHiveMetaDatabaseName);
+    Ndb *idxs_tailer_connection = create_tailer_ndb_connection(mHiveMetaDatabaseName);
     mIDXSTailer = new IDXSTailer(idxs_tailer_connection, mPollMaxTimeToWait,
                                  mBarrier);
+    mIDXSTailer->setEventHub(get_event_hub(mHiveMetaDatabaseName));
 
-    Ndb *skl_tailer_connection = create_ndb_connection(mHiveMetaDatabaseName);
+    Ndb *skl_tailer_connection = create_tailer_ndb_connection(mHiveMetaDatabaseName);
     mSkewedLocTailer = new SkewedLocTailer(skl_tailer_connection,
         mPollMaxTimeToWait, mBarrier);
+    mSkewedLocTailer->setEventHub(get_event_hub(mHiveMetaDatabaseName));
 
-    Ndb *skv_tailer_connection = create_ndb_connection(mHiveMetaDatabaseName);
+    Ndb *skv_tailer_connection = create_tailer_ndb_connection(mHiveMetaDatabaseName);
     mSkewedValuesTailer = new SkewedValuesTailer(skv_tailer_connection,
         mPollMaxTimeToWait, mBarrier);
+    mSkewedValuesTailer->setEventHub(get_event_hub(mHiveMetaDatabaseName));
   }
 
   if(mStats) {
     std::vector<MetricsProvider*> providers;
     if(mMutationsTU.isEnabled()){
       providers.push_back(mProjectsElasticSearch);
+      providers.push_back(mFsMutationsTableTailer);
+      providers.insert(providers.end(), mFsMutationsDataReaders.begin(),
+          mFsMutationsDataReaders.end());
+    }
+    if(mSchemabasedTU.isEnabled()){
+      providers.push_back(mMetadataLogTailer);
+      providers.push_back(mSchemabasedMetadataReaders);
     }
     if(mFileProvenanceTU.isEnabled()){
       providers.push_back(mFileProvenanceElastic);
+      providers.push_back(mFileProvenanceTableTailer);
+      providers.push_back(mFileProvenanceElasticDataReaders);
     }
     if(mAppProvenanceTU.isEnabled()){
       providers.push_back(mAppProvenanceElastic);
+      providers.push_back(mAppProvenanceTableTailer);
+      providers.push_back(mAppProvenanceElasticDataReaders);
     }
+    providers.push_back(&MemoryAccounting::getInstance());
     mMetricsProviders = new MetricsProviders(providers);
     mHttpServer = new HttpServer(mMetricsServer, *mMetricsProviders);
   }
 }
 
+/*
+ * connection a tailer creates and drops its event on. It polls the events
+ * on it as well, unless the tailers share event hubs, then only the Ndb of
+ * the hub buffers events
+ */
+Ndb* Notifier::create_tailer_ndb_connection(const char* database) {
+  if (mEventHubs > 0) {
+    return create_ndb_connection(database);
+  }
+  return create_event_ndb_connection(database);
+}
+
+/*
+ * connection used to poll events, the cap on its event buffer bounds how much
+ * the cluster buffers for us while backpressure holds the tailer back
+ */
+Ndb* Notifier::create_event_ndb_connection(const char* database) {
+  Ndb* ndb = create_ndb_connection(database);
+  if (mEventBufMaxAllocMB > 0) {
+    ndb->set_eventbuf_max_alloc(static_cast<unsigned>(mEventBufMaxAllocMB) * 1024 * 1024);
+  }
+  if (mEventBufFreePercent > 0
+      && ndb->set_eventbuffer_free_percent(mEventBufFreePercent) != 0) {
+    LOG_ERROR("invalid eventbuf_free_percent " << mEventBufFreePercent
+        << ", keeping " << ndb->get_eventbuffer_free_percent());
+  }
+  return ndb;
+}
+
+/*
+ * the tailers of a database share up to event_hubs Ndb objects and poll
+ * threads, handed out round robin in the order the tailers are created.
+ * nullptr lets the tailer poll on its own
+ */
+EventHub* Notifier::get_event_hub(const char* database) {
+  if (mEventHubs <= 0) {
+    return nullptr;
+  }
+  std::vector<EventHub*>& hubs = mEventHubsByDatabase[database];
+  int next = mNextEventHub[database]++ % mEventHubs;
+  if (next == static_cast<int>(hubs.size())) {
+    hubs.push_back(new EventHub(create_event_ndb_connection(database),
+        mPollMaxTimeToWait, Utils::concat(database, "-" + std::to_string(next))));
+  }
+  return hubs[next];
+}
+
+/*
+ * connections scanning the partitions of a log table in parallel during
+ * recovery, none unless recovery_scan_parallelism is above 1
+ */
+std::vector<Ndb*> Notifier::create_recovery_scan_connections(const char* database) {
+  std::vector<Ndb*> connections;
+  if ((mRecovery || mGapRecovery) && mRecoveryScanParallelism > 1) {
+    for (int i = 0; i < mRecoveryScanParallelism; i++) {
+      connections.push_back(create_ndb_connection(database));
+    }
+  }
+  return connections;
+}
+
+/*
+ * only the tailers whose rows all end up acknowledged by the sinks get a
+ * checkpoint, the metadata log reader drops rows it cannot resolve
+ */
+EpochCheckpoint* Notifier::create_checkpoint(LogType type, const std::string name) {
+  if (!mRecovery || mCheckpointDir.empty()) {
+    return nullptr;
+  }
+  return EpochCheckpoint::create(mCheckpointDir, type, name);
+}
+
 Notifier::~Notifier() {
+  EpochCheckpoint::flushAll();
   delete mFsMutationsTableTailer;
-  delete mFsMutationsDataReaders;
-  delete mFsMutationsBatcher;
+  for (auto readers : mFsMutationsDataReaders) {
+    delete readers;
+  }
+  for (auto batcher : mFsMutationsBatchers) {
+    delete batcher;
+  }
   delete mMetadataLogTailer;
   delete mSchemabasedMetadataReaders;
   delete mSchemabasedMetadataBatcher;
@@ -26,7 +26,7 @@ ProjectsElasticSearch::ProjectsElasticSearch(const HttpClientConfig elastic_clie
         int time_to_wait_before_inserting,
         int bulk_size, const bool stats, MConn conn) : ElasticSearchBase
         (elastic_client_config, time_to_wait_before_inserting, bulk_size, stats,
-         new MovingCountersBulkSet("fs")),
+         "fs", new MovingCountersBulkSet("fs")),
          mConn(conn) {
   mElasticBulkAddr = getElasticSearchBulkUrl();
 }
@@ -62,6 +62,7 @@ void ProjectsElasticSearch::process(std::vector<eBulk>* bulks) {
     if(hopsworkslogs > 0){
       HopsworksOpsLogTable().removeLogs(mConn.metadataConnection, logRHandlers);
     }
+    EpochCheckpoint::acknowledgeLogs(logRHandlers);
 
     if (mStats) {
       mCounters->bulksProcessed(start_time, bulks);
@@ -90,6 +91,7 @@ bool ProjectsElasticSearch::bulkRequest(eEvent& event) {
     }else if(event.getLogHandler()->getType() == LogType::METALOG || event.getLogHandler()->getType() == LogType::HOPSWORKSLOG){
       event.getLogHandler()->removeLog(mConn.metadataConnection);
     }
+    EpochCheckpoint::acknowledgeLog(event.getLogHandler());
     return true;
   }
   return false;
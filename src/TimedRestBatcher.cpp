@@ -19,28 +19,42 @@
 
 #include "TimedRestBatcher.h"
 
-TimedRestBatcher::TimedRestBatcher(const HttpClientConfig elastic_client_config, int time_to_wait_before_inserting, int bulk_size)
-    : Batcher(time_to_wait_before_inserting, bulk_size), mToProcessLength(0), mHttpClient(elastic_client_config){
+TimedRestBatcher::TimedRestBatcher(const HttpClientConfig elastic_client_config, int time_to_wait_before_inserting, int bulk_size,
+    const std::string pipe) : Batcher(time_to_wait_before_inserting, bulk_size), mToProcessLength(0), mHttpClient(elastic_client_config){
   mToProcess = new std::vector<eBulk>();
   mShutdown = false;
   mElasticConnetionFailed = false;
-  mCurrentQueueSize = 0;
+  mPendingBytes = MemoryAccounting::getInstance().getAccount(pipe, "sink");
   mToProcessEvents = 0;
+  mToProcessBytes = 0;
+  mFirstPendingUs = 0;
 }
 
 void TimedRestBatcher::addData(eBulk data) {
   LOG_DEBUG("Add Bulk JSON:" << std::endl << data.batchJSON() << std::endl);
   if(!data.mEvents.empty()){
+    // blocks the readers while elastic is behind
+    mPendingEvents.acquire(data.mEvents.size());
+    mPendingBytes->add(data.getByteSize());
     mQueue.push(data);
-    mCurrentQueueSize += data.mEvents.size();
   }else{
     LOG_DEBUG("Skip empty bulk: " << data.toString());
   }
 }
 
+void TimedRestBatcher::setWatermarks(const Watermarks watermarks) {
+  mPendingEvents.setWatermarks(watermarks);
+}
+
+Uint32 TimedRestBatcher::getPendingEvents() {
+  return mPendingEvents.getCount();
+}
+
 void TimedRestBatcher::shutdown(){
   LOG_INFO("Shutting down timed rest batcher...");
   mShutdown = true;
+  // wake up the batcher thread in case it waits on an empty queue
+  mQueue.push(eBulk());
 }
 
 void TimedRestBatcher::run() {
@@ -50,21 +64,51 @@ void TimedRestBatcher::run() {
       Batcher::shutdown();
       break;
     }
+    mLock.lock();
+    Int64 firstPendingUs = mToProcessLength > 0 ? mFirstPendingUs : 0;
+    mLock.unlock();
+
     eBulk msg;
-    mQueue.wait_and_pop(msg);
+    if (firstPendingUs > 0 && isIdleFlushEnabled()) {
+      if (!mQueue.wait_and_pop(msg, getIdleLingerUS(firstPendingUs))) {
+        // nothing arrived until the linger ran out
+        processBatch();
+        continue;
+      }
+    } else {
+      mQueue.wait_and_pop(msg);
+    }
+
+    if (msg.mEvents.empty()) {
+      // flush requested by the timer or by shutdown
+      processBatch();
+      continue;
+    }
 
     mLock.lock();
+    if (mToProcessLength == 0) {
+      mFirstPendingUs = Utils::getMonotonicTimeInMicroseconds();
+    }
     mToProcess->push_back(msg);
     mToProcessLength += msg.mJSONLength;
     mToProcessEvents += msg.mEvents.size();
+    mToProcessBytes += msg.getByteSize();
+    bool idleFlush = isIdleFlushEnabled() && mQueue.empty()
+        && getIdleLingerUS(mFirstPendingUs) == 0;
     mLock.unlock();
 
-    if (mToProcessLength >= mBatchSize && !mTimerProcessing) {
+    if (mToProcessLength >= mBatchSize || idleFlush) {
       processBatch();
     }
   }
 }
 
+void TimedRestBatcher::timerExpired() {
+  // requests to elastic can block for long, so the flush is handed over to
+  // the batcher thread instead of running on the shared timer thread
+  mQueue.push(eBulk());
+}
+
 void TimedRestBatcher::processBatch() {
   if (mToProcessLength > 0) {
     LOG_DEBUG("Process Bulk JSONs [" << mToProcessLength << "]");
@@ -73,11 +117,15 @@ void TimedRestBatcher::processBatch() {
     std::vector<eBulk >* data = mToProcess;
     mToProcess = new std::vector<eBulk >;
     mToProcessLength = 0;
-    mCurrentQueueSize -= mToProcessEvents;
+    int events = mToProcessEvents;
     mToProcessEvents = 0;
+    Uint64 bytes = mToProcessBytes;
+    mToProcessBytes = 0;
     mLock.unlock();
 
     process(data);
+    mPendingEvents.release(events);
+    mPendingBytes->release(bytes);
 
     delete data;
   }
@@ -85,7 +133,6 @@ void TimedRestBatcher::processBatch() {
   if(mShutdown){
     LOG_INFO("Shutting down, remaining " << mQueue.size() << " bulks to process");
     if(mQueue.empty()){
-      mQueue.push(eBulk());
       Batcher::shutdown();
     }
   }
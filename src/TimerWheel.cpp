@@ -0,0 +1,161 @@
+/*
+ * This file is part of ePipe
+ * Copyright (C) 2019, Logical Clocks AB. All rights reserved
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "TimerWheel.h"
+
+Timer::Timer(std::function<void()> callback) : mCallback(callback),
+mExpiry(0), mIntervalTicks(0), mScheduled(false), mFiring(false) {
+}
+
+TimerWheel& TimerWheel::getInstance() {
+  // never destroyed, the wheel thread outlives static destruction at exit
+  static TimerWheel* instance = new TimerWheel();
+  return *instance;
+}
+
+TimerWheel::TimerWheel() : mStartTime(std::chrono::steady_clock::now()),
+mCurrentTick(0) {
+  mThread = boost::thread(&TimerWheel::run, this);
+}
+
+void TimerWheel::start(Timer* timer, int first_delay_ms, int interval_ms) {
+  std::lock_guard<std::mutex> lock(mLock);
+  timer->mIntervalTicks = toTicks(interval_ms);
+  timer->unlink();
+  insert(timer, mCurrentTick + toTicks(first_delay_ms));
+  timer->mScheduled = true;
+}
+
+void TimerWheel::reset(Timer* timer) {
+  std::lock_guard<std::mutex> lock(mLock);
+  if (!timer->mScheduled) {
+    return;
+  }
+  timer->unlink();
+  insert(timer, mCurrentTick + timer->mIntervalTicks);
+}
+
+void TimerWheel::cancel(Timer* timer) {
+  std::unique_lock<std::mutex> lock(mLock);
+  timer->unlink();
+  timer->mScheduled = false;
+  if (boost::this_thread::get_id() == mThread.get_id()) {
+    // cancelled from its own callback
+    return;
+  }
+  mFired.wait(lock, [timer] { return !timer->mFiring; });
+}
+
+Uint64 TimerWheel::toTicks(int delay_ms) {
+  Uint64 ticks = (delay_ms + TIMER_WHEEL_TICK_MS - 1) / TIMER_WHEEL_TICK_MS;
+  return ticks > 0 ? ticks : 1;
+}
+
+void TimerWheel::insert(Timer* timer, Uint64 expiry) {
+  const Uint64 maxDelta = (static_cast<Uint64>(1) << (TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOT_BITS)) - 1;
+  if (expiry < mCurrentTick) {
+    expiry = mCurrentTick;
+  } else if (expiry - mCurrentTick > maxDelta) {
+    expiry = mCurrentTick + maxDelta;
+  }
+  timer->mExpiry = expiry;
+
+  Uint64 delta = expiry - mCurrentTick;
+  int level = 0;
+  while (level < TIMER_WHEEL_LEVELS - 1
+      && delta >= (static_cast<Uint64>(1) << ((level + 1) * TIMER_WHEEL_SLOT_BITS))) {
+    level++;
+  }
+
+  int slot = (expiry >> (level * TIMER_WHEEL_SLOT_BITS)) & (TIMER_WHEEL_SLOTS - 1);
+  mSlots[level][slot].append(timer);
+}
+
+void TimerWheel::run() {
+  std::unique_lock<std::mutex> lock(mLock);
+  while (true) {
+    auto nextTick = mStartTime + std::chrono::milliseconds(
+        (mCurrentTick + 1) * TIMER_WHEEL_TICK_MS);
+    mFired.wait_until(lock, nextTick);
+    while (std::chrono::steady_clock::now() >= nextTick) {
+      advance();
+      nextTick += std::chrono::milliseconds(TIMER_WHEEL_TICK_MS);
+    }
+
+    lock.unlock();
+    fireExpired();
+    lock.lock();
+  }
+}
+
+/*
+ * process the tick mCurrentTick, upper levels are cascaded down when the
+ * lower level wraps around, the same way as the classic Linux timer wheel
+ */
+void TimerWheel::advance() {
+  int index = mCurrentTick & (TIMER_WHEEL_SLOTS - 1);
+  if (index == 0) {
+    cascade(1);
+  }
+
+  TimerNode& slot = mSlots[0][index];
+  while (slot.linked()) {
+    TimerNode* node = slot.mNext;
+    node->unlink();
+    mExpired.append(node);
+  }
+  mCurrentTick++;
+}
+
+void TimerWheel::cascade(int level) {
+  if (level >= TIMER_WHEEL_LEVELS) {
+    return;
+  }
+  int index = (mCurrentTick >> (level * TIMER_WHEEL_SLOT_BITS)) & (TIMER_WHEEL_SLOTS - 1);
+  if (index == 0) {
+    cascade(level + 1);
+  }
+
+  TimerNode& slot = mSlots[level][index];
+  while (slot.linked()) {
+    Timer* timer = static_cast<Timer*>(slot.mNext);
+    timer->unlink();
+    insert(timer, timer->mExpiry);
+  }
+}
+
+void TimerWheel::fireExpired() {
+  std::unique_lock<std::mutex> lock(mLock);
+  while (mExpired.linked()) {
+    Timer* timer = static_cast<Timer*>(mExpired.mNext);
+    timer->unlink();
+    timer->mFiring = true;
+    lock.unlock();
+
+    timer->mCallback();
+
+    lock.lock();
+    timer->mFiring = false;
+    // rearm periodic timers unless they were cancelled or reset meanwhile
+    if (timer->mScheduled && !timer->linked()) {
+      insert(timer, timer->mExpiry + timer->mIntervalTicks);
+    }
+    mFired.notify_all();
+  }
+}
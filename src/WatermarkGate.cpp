@@ -0,0 +1,77 @@
+/*
+ * This file is part of ePipe
+ * Copyright (C) 2019, Logical Clocks AB. All rights reserved
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "WatermarkGate.h"
+
+WatermarkGate::WatermarkGate() : mCount(0), mBlocked(false),
+mBlockedTimeUs(0) {
+}
+
+void WatermarkGate::setWatermarks(const Watermarks watermarks) {
+  boost::mutex::scoped_lock lock(mLock);
+  mWatermarks = watermarks;
+}
+
+void WatermarkGate::acquire(const Uint64 count) {
+  boost::mutex::scoped_lock lock(mLock);
+  if (mBlocked) {
+    Int64 startUs = Utils::getMonotonicTimeInMicroseconds();
+    while (mBlocked) {
+      mReleased.wait(lock);
+    }
+    mBlockedTimeUs += Utils::getMonotonicTimeInMicroseconds() - startUs;
+  }
+  add(count);
+}
+
+void WatermarkGate::add(const Uint64 count) {
+  mCount += count;
+  if (mWatermarks.isEnabled() && mCount >= static_cast<Uint64>(mWatermarks.mHigh)) {
+    if (!mBlocked) {
+      LOG_DEBUG("high watermark reached [" << mCount << "], blocking producers");
+    }
+    mBlocked = true;
+  }
+}
+
+void WatermarkGate::release(const Uint64 count) {
+  boost::mutex::scoped_lock lock(mLock);
+  mCount = count < mCount ? mCount - count : 0;
+  if (mBlocked && mCount <= static_cast<Uint64>(mWatermarks.mLow)) {
+    LOG_DEBUG("low watermark reached [" << mCount << "], resuming producers");
+    mBlocked = false;
+    lock.unlock();
+    mReleased.notify_all();
+  }
+}
+
+Uint64 WatermarkGate::getCount() {
+  boost::mutex::scoped_lock lock(mLock);
+  return mCount;
+}
+
+bool WatermarkGate::isBlocked() {
+  boost::mutex::scoped_lock lock(mLock);
+  return mBlocked;
+}
+
+Uint64 WatermarkGate::getBlockedTimeUs() {
+  boost::mutex::scoped_lock lock(mLock);
+  return mBlockedTimeUs;
+}
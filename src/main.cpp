@@ -64,6 +64,23 @@ int main(int argc, char** argv) {
 
     std::string metricsServer = "0.0.0.0:9191";
 
+    bool work_stealing = false;
+    int fs_mutations_lanes = 1;
+    int idle_flush_linger_us = -1;
+    Watermarks reader_watermarks = Watermarks(64, 32);
+    Watermarks elastic_watermarks = Watermarks(100000, 50000);
+    int eventbuf_max_alloc_mb = 0;
+    int memory_budget_mb = 0;
+    int tailer_decode_workers = 0;
+    int eventbuf_free_percent = 0;
+    int adaptive_batch_factor = 1;
+    bool gap_recovery = true;
+    int event_hubs = 0;
+    int recovery_batch_rows = 10000;
+    int recovery_scan_parallelism = 1;
+    int recovery_scan_batch = 0;
+    std::string checkpoint_dir = "";
+
     bool sslEnabled = false;
     std::string caPath = "";
     std::string username = "";
@@ -100,6 +117,9 @@ int main(int argc, char** argv) {
          po::value<std::vector<int> >()->default_value(mutations_tu.getVector(),
                                                   mutations_tu.getString())->multitoken(),
          "WAIT_TIME BATCH_SIZE NUM_READERS")
+        ("fs_mutations_lanes",
+         po::value<int>(&fs_mutations_lanes)->default_value(fs_mutations_lanes),
+         "number of dataset lanes, each with its own batcher and NUM_READERS readers")
         ("schamebased_tu",
          po::value<std::vector<int> >()->default_value(schamebased_tu.getVector(),
                                                   schamebased_tu.getString())->multitoken(),
@@ -134,6 +154,53 @@ int main(int argc, char** argv) {
          "enable or disable the metrics server")
         ("metricsServer", po::value<std::string>(&metricsServer)->default_value
             (metricsServer),"binding ip and port for the metrics server")
+        ("work_stealing", po::value<bool>(&work_stealing)->default_value(work_stealing),
+         "let idle data readers take queued batches from busy ones")
+        ("idle_flush_linger_us", po::value<int>(&idle_flush_linger_us)->default_value(idle_flush_linger_us),
+         "flush batches as soon as their input goes idle, after a minimum linger in microseconds. -1 disables it")
+        ("reader_watermarks",
+         po::value<std::vector<int> >()->default_value(reader_watermarks.getVector(),
+                                                  reader_watermarks.getString())->multitoken(),
+         "HIGH LOW number of batches queued at the data readers before the batchers block. 0 0 disables it")
+        ("elastic_watermarks",
+         po::value<std::vector<int> >()->default_value(elastic_watermarks.getVector(),
+                                                  elastic_watermarks.getString())->multitoken(),
+         "HIGH LOW number of events pending for elastic before the data readers block. 0 0 disables it")
+        ("eventbuf_max_alloc",
+         po::value<int>(&eventbuf_max_alloc_mb)->default_value(eventbuf_max_alloc_mb),
+         "max memory in MB of the ndb event buffer of every tailer, 0 is unlimited")
+        ("eventbuf_free_percent",
+         po::value<int>(&eventbuf_free_percent)->default_value(eventbuf_free_percent),
+         "percent of the event buffer that has to be free before a full buffer resumes buffering, 0 keeps the ndb default")
+        ("adaptive_batch_factor",
+         po::value<int>(&adaptive_batch_factor)->default_value(adaptive_batch_factor),
+         "grow the batches up to this factor of BATCH_SIZE as the event buffer of the tailer fills up, 1 disables it")
+        ("gap_recovery",
+         po::value<bool>(&gap_recovery)->default_value(gap_recovery),
+         "rescan the log tables for the epochs lost when the event buffer overflows or is inconsistent")
+        ("event_hubs",
+         po::value<int>(&event_hubs)->default_value(event_hubs),
+         "Ndb objects and poll threads shared by the tailers of every database, the eventbuf settings apply to their Ndb "
+         "and every tailer on a hub handles its events on a decode worker of its own. 0 polls every tailer on its own")
+        ("recovery_batch_rows",
+         po::value<int>(&recovery_batch_rows)->default_value(recovery_batch_rows),
+         "log rows read back per round trip and queued at most during recovery, once a single scan read the keys "
+         "and epochs of the rows. 0 reads 1000 rows per round trip and does not bound the queue")
+        ("recovery_scan_parallelism",
+         po::value<int>(&recovery_scan_parallelism)->default_value(recovery_scan_parallelism),
+         "threads scanning the partitions of a log table in parallel during recovery, 1 scans the whole table on one thread")
+        ("recovery_scan_batch",
+         po::value<int>(&recovery_scan_batch)->default_value(recovery_scan_batch),
+         "rows per partition returned by every round trip of the recovery scans, 0 lets ndb decide")
+        ("checkpoint_dir",
+         po::value<std::string>(&checkpoint_dir)->default_value(checkpoint_dir),
+         "directory of the per log table files holding the highest epoch sent and removed, the recovery starts after it. Empty disables it")
+        ("memory_budget",
+         po::value<int>(&memory_budget_mb)->default_value(memory_budget_mb),
+         "max memory in MB held by the pipeline stages before the tailers stop polling, 0 is unlimited")
+        ("tailer_decode_workers",
+         po::value<int>(&tailer_decode_workers)->default_value(tailer_decode_workers),
+         "threads building rows out of the polled events of every log tailer, 0 builds them on the poll thread")
         ("barrier", po::value<int>()->default_value(barrier),
          "Table tailer barrier type. EPOCH=0, GCI=1")
         ("reindex", po::value<bool>(&reindex)->default_value(reindex),
@@ -198,6 +265,14 @@ int main(int argc, char** argv) {
       provenance_tu.update(vm["provenance_tu"].as<std::vector<int> >());
     }
 
+    if (vm.count("reader_watermarks")) {
+      reader_watermarks.update(vm["reader_watermarks"].as<std::vector<int> >());
+    }
+
+    if (vm.count("elastic_watermarks")) {
+      elastic_watermarks.update(vm["elastic_watermarks"].as<std::vector<int> >());
+    }
+
     if (vm.count("barrier")) {
       barrier = static_cast<Barrier> (vm["barrier"].as<int>());
     }
@@ -259,7 +334,18 @@ int main(int argc, char** argv) {
                                        elastic_batch_size, elastic_issue_time,
                                        lru_cap, prov_file_lru_cap, prov_core_lru_cap,
                                        recovery, stats, barrier,
-                                       hiveCleaner, metricsServer);
+                                       hiveCleaner, metricsServer, work_stealing,
+                                       fs_mutations_lanes, idle_flush_linger_us,
+                                       reader_watermarks, elastic_watermarks,
+                                       eventbuf_max_alloc_mb, memory_budget_mb,
+                                       tailer_decode_workers,
+                                       eventbuf_free_percent,
+                                       adaptive_batch_factor,
+                                       gap_recovery, event_hubs,
+                                       recovery_batch_rows,
+                                       recovery_scan_parallelism,
+                                       recovery_scan_batch,
+                                       checkpoint_dir);
       notifer->start();
     }
     return EXIT_SUCCESS;
@@ -0,0 +1,90 @@
+/*
+ * This file is part of ePipe
+ * Copyright (C) 2019, Logical Clocks AB. All rights reserved
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+/*
+ * Single consumer handoff microbenchmark for ConcurrentQueue versus
+ * ConcurrentRingBuffer. Not part of the CMake build, compile it by hand with
+ * the same include paths as ePipe:
+ *
+ *   g++ -O2 -std=c++14 -Iinclude -I<ndb>/include -I<ndb>/include/ndbapi \
+ *     -I<rapidjson>/include tests/queues/queue_benchmark.cpp \
+ *     -lboost_thread -lboost_chrono -lboost_system -lpthread
+ *
+ * Recorded with 4M rows, 16384 slots, g++ -O2 on a single core:
+ *
+ *   producers  ConcurrentQueue   ConcurrentRingBuffer
+ *   1          3.9 - 4.6 Mops/s  21.7 - 23.6 Mops/s
+ *   2          5.9 - 6.5 Mops/s  21.1 - 23.2 Mops/s
+ *   4          6.6 - 6.7 Mops/s  20.6 - 22.9 Mops/s
+ */
+
+#include "ConcurrentQueue.h"
+#include "ConcurrentRingBuffer.h"
+#include <chrono>
+
+struct Row {
+  long mA;
+  long mB;
+  int mC;
+  std::string mS;
+};
+
+template<typename Queue>
+double run(Queue& queue, int producers, long rows) {
+  long perProducer = rows / producers;
+  auto start = std::chrono::steady_clock::now();
+  std::vector<boost::thread> threads;
+  for (int p = 0; p < producers; p++) {
+    threads.emplace_back([&queue, perProducer]() {
+      for (long i = 0; i < perProducer; i++) {
+        queue.push(Row{i, i, 1, "x"});
+      }
+    });
+  }
+  Row row;
+  long sum = 0;
+  for (long i = 0; i < perProducer * producers; i++) {
+    queue.wait_and_pop(row);
+    sum += row.mA;
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto end = std::chrono::steady_clock::now();
+  if (sum < 0) {
+    printf("unexpected sum %ld\n", sum);
+  }
+  return std::chrono::duration<double>(end - start).count();
+}
+
+int main() {
+  const long rows = 4000000;
+  const int repeats = 3;
+  for (int producers : {1, 2, 4}) {
+    for (int r = 0; r < repeats; r++) {
+      ConcurrentQueue<Row> queue;
+      ConcurrentRingBuffer<Row> ring(16384);
+      double queueSecs = run(queue, producers, rows);
+      double ringSecs = run(ring, producers, rows);
+      printf("producers=%d queue %.1f Mops/s ring %.1f Mops/s\n", producers,
+          rows / queueSecs / 1e6, rows / ringSecs / 1e6);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,44 @@
+-- Recovery time of a synthetic million row hdfs_metadata_log.
+-- Needs a RonDB/NDB cluster with the hops schema and ePipe stopped.
+--
+-- 1. Set checkpoint_dir empty (or remove the hdfs_metadata_log checkpoint
+--    file) so the recovery reads the whole log table.
+-- 2. Run this script against the hops database.
+-- 3. Start ePipe with recovery = true and log_level = 2, once with
+--    recovery_scan_parallelism = 1 and once with it set to the number of
+--    data nodes. Remove the log rows left over between the runs and reload.
+-- 4. Compare the "ePipe done reading" and "recovery done in" lines of
+--    hdfs_metadata_log. The first one splits the time between the key scan
+--    and the batched read back, the second one is the whole recovery.
+
+DROP TABLE IF EXISTS `recovery_digits`;
+CREATE TABLE `recovery_digits` (
+  `d` tinyint NOT NULL,
+  PRIMARY KEY (`d`)
+) ENGINE=ndbcluster;
+INSERT INTO recovery_digits VALUES (0),(1),(2),(3),(4),(5),(6),(7),(8),(9);
+
+-- a single transaction of a million rows runs out of operation records
+SET ndb_use_transactions=0;
+
+-- 1000 datasets of 1000 inodes, one FsAdd each. The inodes do not exist,
+-- so the readers only send deletes to elastic and remove the log rows,
+-- which leaves the recovery itself as the measured part
+INSERT INTO hdfs_metadata_log (dataset_id, inode_id, logical_time, pk1, pk2,
+  pk3, operation, inode_partition_id, inode_parent_id, inode_name)
+SELECT 100000000 + n DIV 1000, 200000000 + n, 1, 0, 0, '', 0, 200000000 + n,
+  100000000 + n DIV 1000, CONCAT('file_', n)
+FROM (SELECT a.d + 10 * b.d + 100 * c.d + 1000 * d.d + 10000 * e.d
+  + 100000 * f.d AS n
+  FROM recovery_digits a, recovery_digits b, recovery_digits c,
+  recovery_digits d, recovery_digits e, recovery_digits f) AS numbers;
+
+SET ndb_use_transactions=1;
+
+-- Should be 1000000
+SELECT COUNT(*) FROM hdfs_metadata_log WHERE dataset_id >= 100000000;
+
+-- After the recovery run, should be 0 once elastic acknowledged every delete
+SELECT COUNT(*) FROM hdfs_metadata_log WHERE dataset_id >= 100000000;
+
+DROP TABLE `recovery_digits`;
@@ -0,0 +1,122 @@
+/*
+ * This file is part of ePipe
+ * Copyright (C) 2019, Logical Clocks AB. All rights reserved
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+/*
+ * Counts the heap allocations of RecAttrArena over repeated transactions:
+ * once the first transaction sized the blocks, the following ones of the
+ * same shape must not allocate at all, and no two arrays handed out within
+ * one transaction may overlap. Not part of the CMake build, compile it by
+ * hand with the same paths as ePipe:
+ *
+ *   g++ -O2 -std=c++14 -Iinclude -I<ndb>/include \
+ *     -I<ndb>/include/storage/ndb -I<ndb>/include/storage/ndb/ndbapi \
+ *     -I<rapidjson>/include tests/tables/rec_attr_arena_test.cpp
+ */
+
+#include "tables/RecAttrArena.h"
+#include <atomic>
+#include <new>
+
+static std::atomic<Uint64> allocations(0);
+
+void* operator new(std::size_t size) {
+  allocations++;
+  void* p = std::malloc(size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+  std::free(p);
+}
+
+#define TRANSACTIONS 1000
+
+static int failures = 0;
+
+#define CHECK(cond, msg) \
+  if (!(cond)) { \
+    std::cerr << "FAILED " << msg << std::endl; \
+    failures++; \
+  }
+
+/*
+ * one transaction of reads with the given number of columns each, every
+ * array is filled with its own marker so an overlap shows up as a changed
+ * marker
+ */
+static void transaction(RecAttrArena& arena, const std::vector<Uint32>& reads,
+    std::vector<NdbRecAttr**>& arrays) {
+  arrays.clear();
+  for (std::size_t r = 0; r < reads.size(); r++) {
+    NdbRecAttr** values = arena.allocate(reads[r]);
+    for (Uint32 c = 0; c < reads[r]; c++) {
+      values[c] = reinterpret_cast<NdbRecAttr*>(r + 1);
+    }
+    arrays.push_back(values);
+  }
+  for (std::size_t r = 0; r < reads.size(); r++) {
+    for (Uint32 c = 0; c < reads[r]; c++) {
+      CHECK(arrays[r][c] == reinterpret_cast<NdbRecAttr*>(r + 1),
+          "array " << r << " was overwritten at column " << c);
+    }
+  }
+  arena.reset();
+}
+
+int main() {
+  // enriched batches, a wide row wider than a block and a single key read
+  std::vector<std::vector<Uint32> > shapes = {
+    std::vector<Uint32>(1000, 10),
+    {3, REC_ATTR_ARENA_BLOCK + 1, 7},
+    {1}
+  };
+
+  for (auto& reads : shapes) {
+    RecAttrArena arena;
+    std::vector<NdbRecAttr**> arrays;
+    arrays.reserve(reads.size());
+    transaction(arena, reads, arrays);
+    Uint64 warm = allocations.load();
+    for (int t = 1; t < TRANSACTIONS; t++) {
+      transaction(arena, reads, arrays);
+    }
+    Uint64 extra = allocations.load() - warm;
+    CHECK(extra == 0, extra << " allocations after the first of "
+        << TRANSACTIONS << " transactions of " << reads.size() << " reads");
+  }
+
+  // the old per read allocation, for comparison
+  Uint64 before = allocations.load();
+  for (int r = 0; r < 1000; r++) {
+    NdbRecAttr** values = new NdbRecAttr*[10];
+    delete[] values;
+  }
+  std::cout << "1000 reads allocate " << allocations.load() - before
+      << " times without the arena" << std::endl;
+
+  std::cout << (failures == 0 ? "PASSED" : "FAILED") << std::endl;
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,179 @@
+/*
+ * This file is part of ePipe
+ * Copyright (C) 2019, Logical Clocks AB. All rights reserved
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+/*
+ * Property test of the string helpers of DBTableBase on random strings:
+ *  - latin1_to_utf8 matches the plain byte by byte conversion
+ *  - a string written by write_ndb_varchar reads back unchanged through
+ *    get_string_view, for fixed, short and medium var chars
+ *  - the bytes of the column after the string hold the fill byte
+ *  - strings longer than the column are refused instead of cut
+ * Not part of the CMake build, compile it by hand with the same paths as
+ * ePipe and link it against ndbclient for the dictionary columns:
+ *
+ *   g++ -O2 -std=c++14 -DDBUG_OFF -Iinclude -I<ndb>/include \
+ *     -I<ndb>/include/storage/ndb -I<ndb>/include/storage/ndb/ndbapi \
+ *     -I<rapidjson>/include tests/tables/string_codec_test.cpp src/Logger.cpp \
+ *     -L<ndb>/lib -lndbclient -lboost_log -lboost_thread -lboost_system \
+ *     -lboost_date_time -lpthread
+ */
+
+#include "tables/DBTableBase.h"
+#include <random>
+
+#define ITERATIONS 200000
+#define MAX_LENGTH 300
+
+class StringCodec : public DBTableBase {
+public:
+  StringCodec() : DBTableBase("string_codec_test") {
+  }
+  using DBTableBase::latin1_to_utf8;
+  using DBTableBase::write_ndb_varchar;
+  using DBTableBase::get_string_view;
+};
+
+/*
+ * the parts of NdbRecAttr that get_string_view reads, over a key buffer
+ */
+struct BufferRecAttr {
+  const NdbDictionary::Column* mColumn;
+  const char* mBuffer;
+  Uint32 mSize;
+
+  const NdbDictionary::Column* getColumn() const {
+    return mColumn;
+  }
+
+  Uint32 get_size_in_bytes() const {
+    return mSize;
+  }
+
+  const char* aRef() const {
+    return mBuffer;
+  }
+
+  NdbDictionary::Column::Type getType() const {
+    return mColumn->getType();
+  }
+};
+
+static std::string reference_latin1_to_utf8(const std::string& str) {
+  std::string out;
+  for (unsigned char ch : str) {
+    if (ch < 0x80) {
+      out.push_back(ch);
+    } else {
+      out.push_back(0xc0 | ch >> 6);
+      out.push_back(0x80 | (ch & 0x3f));
+    }
+  }
+  return out;
+}
+
+/*
+ * mostly ascii with a few latin1 bytes, like file and user names, and now
+ * and then fully random bytes
+ */
+static std::string random_string(std::mt19937& rng, std::size_t length,
+    bool trailingBlanks) {
+  std::uniform_int_distribution<int> kind(0, 9);
+  std::uniform_int_distribution<int> ascii(0x21, 0x7e);
+  std::uniform_int_distribution<int> high(0x80, 0xff);
+  std::uniform_int_distribution<int> any(0, 0xff);
+  bool noisy = kind(rng) == 0;
+  std::string str;
+  for (std::size_t i = 0; i < length; i++) {
+    int k = kind(rng);
+    str.push_back(static_cast<char>(noisy ? any(rng)
+        : k == 0 ? high(rng) : k == 1 ? ' ' : ascii(rng)));
+  }
+  if (!trailingBlanks) {
+    while (!str.empty() && str.back() == ' ') {
+      str.back() = 'x';
+    }
+  }
+  return str;
+}
+
+static int failures = 0;
+
+#define CHECK(cond, msg) \
+  if (!(cond) && failures++ < 20) { \
+    std::cerr << "FAILED " << msg << std::endl; \
+  }
+
+static void check_column(StringCodec& codec, std::mt19937& rng,
+    NdbDictionary::Column::Type type, int length) {
+  NdbDictionary::Column column("c");
+  column.setType(type);
+  column.setLength(length);
+  const bool fixed = type == NdbDictionary::Column::Char;
+  const char fill = fixed ? ' ' : 0;
+  const std::size_t size = column.getSizeInBytes();
+  const std::size_t prefix = fixed ? 0
+      : type == NdbDictionary::Column::Varchar ? 1 : 2;
+  std::vector<char> buffer(size + 1);
+
+  std::uniform_int_distribution<int> lengths(0, length);
+  for (int i = 0; i < ITERATIONS / 10; i++) {
+    // fixed chars lose their trailing blanks, the same way mysql does
+    std::string str = random_string(rng, lengths(rng), !fixed);
+    buffer[size] = '#';
+    int written = codec.write_ndb_varchar(str, &column, buffer.data());
+    CHECK(written == static_cast<int>(size), "wrote " << written
+        << " bytes of a " << size << " bytes column");
+    CHECK(buffer[size] == '#', "wrote past the column");
+
+    BufferRecAttr attr = {&column, buffer.data(), static_cast<Uint32>(size)};
+    boost::string_view read = codec.get_string_view(&attr);
+    CHECK(read == str, "type " << type << " read back ["
+        << read << "] instead of [" << str << "]");
+    for (std::size_t b = prefix + str.length(); b < size; b++) {
+      CHECK(buffer[b] == fill, "type " << type << " byte " << b
+          << " is not the fill byte");
+    }
+  }
+
+  std::string tooLong = random_string(rng, size - prefix + 1, true);
+  CHECK(codec.write_ndb_varchar(tooLong, &column, buffer.data()) == -1,
+      "type " << type << " accepted " << tooLong.length()
+      << " bytes into a " << size << " bytes column");
+}
+
+int main() {
+  StringCodec codec;
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> lengths(0, MAX_LENGTH);
+
+  for (int i = 0; i < ITERATIONS; i++) {
+    std::string str = random_string(rng, lengths(rng), true);
+    std::string expected = reference_latin1_to_utf8(str);
+    std::string actual = codec.latin1_to_utf8(boost::string_view(str));
+    CHECK(actual == expected, "latin1_to_utf8 of [" << str << "] gave ["
+        << actual << "] instead of [" << expected << "]");
+  }
+
+  check_column(codec, rng, NdbDictionary::Column::Char, 100);
+  check_column(codec, rng, NdbDictionary::Column::Varchar, 255);
+  check_column(codec, rng, NdbDictionary::Column::Longvarchar, 3000);
+
+  std::cout << (failures == 0 ? "PASSED" : "FAILED") << std::endl;
+  return failures == 0 ? 0 : 1;
+}
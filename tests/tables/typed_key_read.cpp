@@ -0,0 +1,104 @@
+/*
+ * This file is part of ePipe
+ * Copyright (C) 2019, Logical Clocks AB. All rights reserved
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+/*
+ * Checks that the batched typed primary key read returns the same rows as
+ * one AnyMap read per key, and times both over the same keys. Needs a
+ * cluster with the users of typed_key_read.sql loaded. Not part of the
+ * CMake build, compile it by hand with the same paths as ePipe:
+ *
+ *   g++ -O3 -std=c++14 -DDBUG_OFF -Iinclude -I<ndb>/include \
+ *     -I<ndb>/include/storage/ndb -I<ndb>/include/storage/ndb/ndbapi \
+ *     -I<rapidjson>/include tests/tables/typed_key_read.cpp src/Logger.cpp \
+ *     -L<ndb>/lib -lndbclient -lboost_log -lboost_thread -lboost_system \
+ *     -lboost_date_time -lpthread
+ *
+ *   ./a.out <connection string> <hops database> [keys]
+ */
+
+#include "tables/UserTable.h"
+
+#define FIRST_TEST_USER 900000000
+#define DEFAULT_KEYS 10000
+
+// the reads are only meant for the table subclasses
+class TestUserTable : public UserTable {
+public:
+  TestUserTable() : UserTable(1) {
+  }
+  using UserTable::doRead;
+};
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    std::cerr << "usage: " << argv[0]
+        << " <connection string> <hops database> [keys]" << std::endl;
+    return 2;
+  }
+  int keys = argc > 3 ? std::atoi(argv[3]) : DEFAULT_KEYS;
+
+  ndb_init();
+  Ndb_cluster_connection* cluster = new Ndb_cluster_connection(argv[1]);
+  if (cluster->connect(4, 5, 1) || cluster->wait_until_ready(30, 30) < 0) {
+    std::cerr << "unable to connect to the cluster" << std::endl;
+    return 2;
+  }
+  Ndb* ndb = new Ndb(cluster, argv[2]);
+  if (ndb->init() == -1) {
+    std::cerr << "unable to init ndb " << ndb->getNdbError().message
+        << std::endl;
+    return 2;
+  }
+
+  TestUserTable users;
+  UISet ids;
+  for (int i = 0; i < keys; i++) {
+    ids.insert(FIRST_TEST_USER + i);
+  }
+
+  ptime t1 = Utils::getCurrentTime();
+  UserMap batched = users.doRead(ndb, ids);
+  ptime t2 = Utils::getCurrentTime();
+  UserMap single;
+  for (int id : ids) {
+    single[id] = users.doRead(ndb, id);
+  }
+  ptime t3 = Utils::getCurrentTime();
+
+  int mismatches = 0;
+  for (int id : ids) {
+    UserRow& a = batched[id];
+    UserRow& b = single[id];
+    if (a.mId != id || a.mId != b.mId || a.mName != b.mName) {
+      std::cerr << "user " << id << " batched (" << a.mId << ", " << a.mName
+          << ") single (" << b.mId << ", " << b.mName << ")" << std::endl;
+      mismatches++;
+    }
+  }
+
+  std::cout << keys << " keys, batched typed read "
+      << Utils::getTimeDiffInMilliseconds(t1, t2) << " msec, single reads "
+      << Utils::getTimeDiffInMilliseconds(t2, t3) << " msec, "
+      << mismatches << " mismatches" << std::endl;
+
+  delete ndb;
+  delete cluster;
+  ndb_end(0);
+  return mismatches == 0 ? 0 : 1;
+}
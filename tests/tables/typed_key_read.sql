@@ -0,0 +1,24 @@
+-- Users read back by typed_key_read.cpp, run against the hops database
+-- before the program and the cleanup at the end after it.
+
+DROP TABLE IF EXISTS `typed_key_digits`;
+CREATE TABLE `typed_key_digits` (
+  `d` tinyint NOT NULL,
+  PRIMARY KEY (`d`)
+) ENGINE=ndbcluster;
+INSERT INTO typed_key_digits VALUES (0),(1),(2),(3),(4),(5),(6),(7),(8),(9);
+
+-- 10000 users with ids from 900000000 and names of varying length
+INSERT INTO hdfs_users (id, name)
+SELECT 900000000 + n, CONCAT('typed_key_user_', REPEAT('x', n MOD 32), n)
+FROM (SELECT a.d + 10 * b.d + 100 * c.d + 1000 * d.d AS n
+  FROM typed_key_digits a, typed_key_digits b, typed_key_digits c,
+  typed_key_digits d) AS numbers;
+
+DROP TABLE `typed_key_digits`;
+
+-- Should be 10000
+SELECT COUNT(*) FROM hdfs_users WHERE id >= 900000000;
+
+-- Cleanup, once typed_key_read.cpp reported 0 mismatches
+DELETE FROM hdfs_users WHERE id >= 900000000;